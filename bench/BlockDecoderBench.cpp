@@ -0,0 +1,173 @@
+#include "stdafx.h"
+#include "BlockDecoderBench.h"
+#include "core/modeling/BlockDecoder.h"
+#include "ddslib.h"
+#include <QJsonArray>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace bench {
+
+	using namespace core;
+
+	namespace {
+
+		constexpr std::array<BlockDecoder::Kernel, 4> kernels = {
+			BlockDecoder::Kernel::SCALAR,
+			BlockDecoder::Kernel::SSE41,
+			BlockDecoder::Kernel::AVX2,
+			BlockDecoder::Kernel::NEON
+		};
+
+		QString kernelName(BlockDecoder::Kernel kernel) {
+			switch (kernel) {
+			case BlockDecoder::Kernel::SSE41:
+				return "sse4.1";
+			case BlockDecoder::Kernel::AVX2:
+				return "avx2";
+			case BlockDecoder::Kernel::NEON:
+				return "neon";
+			default:
+				return "scalar";
+			}
+		}
+
+		QString formatName(BlockDecoder::Format format) {
+			switch (format) {
+			case BlockDecoder::Format::BC2:
+				return "bc2";
+			case BlockDecoder::Format::BC3:
+				return "bc3";
+			default:
+				return "bc1";
+			}
+		}
+
+		void decodeReference(BlockDecoder::Format format, std::vector<uint8_t>& src, uint32_t width, uint32_t height, uint8_t* dest) {
+			switch (format) {
+			case BlockDecoder::Format::BC1:
+				DDSDecompressDXT1(src.data(), width, height, dest);
+				break;
+			case BlockDecoder::Format::BC2:
+				DDSDecompressDXT3(src.data(), width, height, dest);
+				break;
+			case BlockDecoder::Format::BC3:
+				DDSDecompressDXT5(src.data(), width, height, dest);
+				break;
+			}
+		}
+
+		// random blocks, with every 4th block using equal endpoints to cover the 3 colour / 6 alpha modes.
+		std::vector<uint8_t> generateBlocks(BlockDecoder::Format format, uint32_t width, uint32_t height, uint32_t seed) {
+			std::mt19937 rng(seed);
+			std::vector<uint8_t> blocks(BlockDecoder::compressedSize(format, width, height));
+			for (auto& value : blocks) {
+				value = (uint8_t)rng();
+			}
+
+			const auto block_size = BlockDecoder::blockSize(format);
+			const auto color_offset = format == BlockDecoder::Format::BC1 ? 0 : 8;
+			for (size_t i = 0; i + block_size <= blocks.size(); i += block_size * 4) {
+				blocks[i + color_offset + 2] = blocks[i + color_offset];
+				blocks[i + color_offset + 3] = blocks[i + color_offset + 1];
+				if (format == BlockDecoder::Format::BC3) {
+					blocks[i + 1] = blocks[i];
+				}
+			}
+
+			return blocks;
+		}
+
+		template<typename fn>
+		double megapixelsPerSecond(uint32_t width, uint32_t height, uint32_t iterations, fn callback) {
+			const auto start = std::chrono::steady_clock::now();
+			for (uint32_t i = 0; i < iterations; i++) {
+				callback();
+			}
+			const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+			return ((double)width * height * iterations / 1000000.0) / std::max(elapsed.count(), 1e-9);
+		}
+	}
+
+	QJsonObject benchmarkBlockDecoding(uint32_t iterations, bool& matches_reference) {
+		constexpr std::array<BlockDecoder::Format, 3> formats = {
+			BlockDecoder::Format::BC1,
+			BlockDecoder::Format::BC2,
+			BlockDecoder::Format::BC3
+		};
+
+		// ddslib only handles whole blocks, sizes below 4 pixels are compared against the scalar kernel.
+		constexpr std::array<uint32_t, 4> sizes = { 4, 64, 512, 2048 };
+		constexpr std::array<uint32_t, 3> edge_sizes = { 1, 2, 6 };
+
+		matches_reference = true;
+
+		QJsonArray results;
+
+		for (const auto format : formats) {
+			for (const auto size : sizes) {
+				auto blocks = generateBlocks(format, size, size, size);
+				std::vector<uint8_t> expected(size * size * 4);
+				std::vector<uint8_t> actual(size * size * 4);
+
+				decodeReference(format, blocks, size, size, expected.data());
+
+				QJsonObject result;
+				result["format"] = formatName(format);
+				result["width"] = (qint64)size;
+				result["height"] = (qint64)size;
+				result["ddslib_mps"] = megapixelsPerSecond(size, size, iterations, [&]() {
+					decodeReference(format, blocks, size, size, actual.data());
+				});
+
+				QJsonObject kernel_results;
+				for (const auto kernel : kernels) {
+					if (!BlockDecoder::supported(kernel)) {
+						continue;
+					}
+
+					BlockDecoder::decode(format, blocks, size, size, actual.data(), kernel);
+					const bool matches = memcmp(actual.data(), expected.data(), actual.size()) == 0;
+					matches_reference &= matches;
+
+					QJsonObject kernel_result;
+					kernel_result["matches_reference"] = matches;
+					kernel_result["mps"] = megapixelsPerSecond(size, size, iterations, [&]() {
+						BlockDecoder::decode(format, blocks, size, size, actual.data(), kernel);
+					});
+					kernel_results[kernelName(kernel)] = kernel_result;
+				}
+
+				result["kernels"] = kernel_results;
+				results.push_back(result);
+			}
+
+			for (const auto size : edge_sizes) {
+				const auto blocks = generateBlocks(format, size, size, size);
+				std::vector<uint8_t> expected(size * size * 4);
+				std::vector<uint8_t> actual(size * size * 4);
+
+				BlockDecoder::decode(format, blocks, size, size, expected.data(), BlockDecoder::Kernel::SCALAR);
+
+				for (const auto kernel : kernels) {
+					if (BlockDecoder::supported(kernel)) {
+						BlockDecoder::decode(format, blocks, size, size, actual.data(), kernel);
+						matches_reference &= memcmp(actual.data(), expected.data(), actual.size()) == 0;
+					}
+				}
+			}
+		}
+
+		QJsonObject report;
+		report["kernel"] = kernelName(BlockDecoder::kernel());
+		report["iterations"] = (qint64)iterations;
+		report["matches_reference"] = matches_reference;
+		report["results"] = results;
+		return report;
+	}
+};
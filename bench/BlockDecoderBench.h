@@ -0,0 +1,11 @@
+#pragma once
+
+#include <QJsonObject>
+#include <cstdint>
+
+namespace bench {
+
+	// decodes generated BC1 / BC2 / BC3 images with each kernel supported by the cpu,
+	// output is compared against the ddslib reference decoder and throughput reported in megapixels per second.
+	QJsonObject benchmarkBlockDecoding(uint32_t iterations, bool& matches_reference);
+};
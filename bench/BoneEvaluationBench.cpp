@@ -0,0 +1,167 @@
+#include "stdafx.h"
+#include "BoneEvaluationBench.h"
+#include "core/modeling/GenericModelAdaptors.h"
+#include <QJsonArray>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace bench {
+
+	using namespace core;
+
+	namespace {
+
+		constexpr M2_VER_RANGE TIMELINE_VERSION = M2_VER_RANGE::FROM(M2_VER_WOTLK);
+		constexpr M2_VER_RANGE RANGE_VERSION = M2_VER_RANGE(M2_VER_TBC_MIN, M2_VER_WOTLK - 1);
+
+		// keys 1 - 66ms apart, a single animation.
+		template<typename T, M2_VER_RANGE R>
+		AnimatedValue<T, R> generateTrack(std::mt19937& rng, bool used, std::function<T()> value, std::shared_ptr<std::vector<uint32_t>> globals) {
+			std::vector<uint32_t> times;
+			std::vector<T> keys;
+
+			if (used) {
+				const uint32_t count = 2 + rng() % 30;
+				uint32_t time = 0;
+				for (uint32_t i = 0; i < count; i++) {
+					times.push_back(time);
+					keys.push_back(value());
+					time += 1 + rng() % 66;
+				}
+			}
+
+			auto no_fix = [](auto&& val) { return val; };
+
+			if constexpr (M2_VER_CONDITION_AFTER<M2_VER_WOTLK>::eval(R)) {
+				TimelineBasedAnimationBlock<T> block;
+				block.interpolationType = INTERPOLATION_LINEAR;
+				block.globalSequence = -1;
+				block.timestamps = { std::move(times) };
+				block.keys = { std::move(keys) };
+				return AnimatedValue<T, R>::make(std::move(block), globals, no_fix);
+			}
+			else {
+				RangeBasedAnimationBlock<T> block;
+				block.interpolationType = INTERPOLATION_LINEAR;
+				block.globalSequence = -1;
+				// unused tracks have no keys, and so no range.
+				if (!times.empty()) {
+					block.ranges = { AnimationRange{ 0, (uint32_t)times.size() - 1 } };
+				}
+				block.timestamps = std::move(times);
+				block.keys = std::move(keys);
+				return AnimatedValue<T, R>::make(std::move(block), globals, no_fix);
+			}
+		}
+
+		// every parent comes earlier in the list, as the recursive walk cant handle cycles.
+		template<M2_VER_RANGE R>
+		std::vector<std::unique_ptr<ModelBoneAdaptor>> generateSkeleton(uint32_t bone_count, uint32_t seed) {
+			std::mt19937 rng(seed);
+			auto globals = std::make_shared<std::vector<uint32_t>>();
+			std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+			auto vector = [&]() {
+				return Vector3(dist(rng), dist(rng), dist(rng));
+			};
+
+			auto rotation = [&]() {
+				const Quaternion q(dist(rng), dist(rng), dist(rng), dist(rng));
+				const float length = std::sqrt((q.x * q.x) + (q.y * q.y) + (q.z * q.z) + (q.w * q.w));
+				return length > 0.001f ? Quaternion(q.x / length, q.y / length, q.z / length, q.w / length) : Quaternion();
+			};
+
+			std::vector<std::unique_ptr<ModelBoneAdaptor>> bones;
+			bones.reserve(bone_count);
+
+			for (uint32_t i = 0; i < bone_count; i++) {
+				ModelBoneM2<R> definition = {};
+				definition.parentBoneId = i == 0 || rng() % 16 == 0 ? -1 : (int16_t)(rng() % i);
+				definition.pivot = vector();
+				definition.flags = rng() % 16 == 0 ? ModelBoneFlags::spherical_billboard : 0;
+
+				auto translation = generateTrack<Vector3, R>(rng, rng() % 3 == 0, vector, globals);
+				auto rotate = generateTrack<Quaternion, R>(rng, rng() % 3 != 0, rotation, globals);
+				auto scale = generateTrack<Vector3, R>(rng, rng() % 8 == 0, vector, globals);
+
+				bones.push_back(std::make_unique<GenericModelBoneAdaptor<R>>(std::move(definition), std::move(translation), std::move(rotate), std::move(scale)));
+			}
+
+			return bones;
+		}
+
+		bool identical(const ModelBoneAdaptor* a, const ModelBoneAdaptor* b) {
+			return memcmp(&a->getMat(), &b->getMat(), sizeof(Matrix)) == 0 &&
+				memcmp(&a->getMRot(), &b->getMRot(), sizeof(Matrix)) == 0 &&
+				memcmp(&a->getTranslationPivot(), &b->getTranslationPivot(), sizeof(Vector3)) == 0;
+		}
+
+		template<M2_VER_RANGE R>
+		QJsonObject compare(uint32_t bone_count, uint32_t frames, bool& matches_recursive) {
+			auto recursive = generateSkeleton<R>(bone_count, bone_count);
+			auto evaluated = generateSkeleton<R>(bone_count, bone_count);
+			auto& all_bones = reinterpret_cast<std::vector<ModelBoneAdaptor*>&>(recursive);
+
+			GenericModelBoneEvaluator<R> evaluator(evaluated);
+
+			std::chrono::duration<double, std::micro> recursive_time{ 0 }, evaluator_time{ 0 };
+			bool matches = true;
+
+			for (uint32_t frame = 0; frame < frames; frame++) {
+				const AnimationTickArgs tick((frame * 16) % 1000, 16, frame * 16);
+
+				// the walk models did before the evaluator.
+				auto start = std::chrono::steady_clock::now();
+				for (auto& bone : recursive) {
+					bone->resetCalculated();
+				}
+				for (auto& bone : recursive) {
+					bone->calculateMatrix(0, tick, all_bones);
+				}
+				recursive_time += std::chrono::steady_clock::now() - start;
+
+				start = std::chrono::steady_clock::now();
+				evaluator.calculate(0, tick);
+				evaluator_time += std::chrono::steady_clock::now() - start;
+
+				for (uint32_t i = 0; i < bone_count; i++) {
+					matches &= identical(recursive[i].get(), evaluated[i].get());
+				}
+			}
+
+			matches_recursive &= matches;
+
+			QJsonObject result;
+			result["bones"] = (qint64)bone_count;
+			result["tracks"] = M2_VER_CONDITION_AFTER<M2_VER_WOTLK>::eval(R) ? "timeline" : "range";
+			result["recursive_us"] = recursive_time.count() / std::max(1u, frames);
+			result["evaluator_us"] = evaluator_time.count() / std::max(1u, frames);
+			result["speedup"] = result["recursive_us"].toDouble() / std::max(1e-3, result["evaluator_us"].toDouble());
+			result["matches_recursive"] = matches;
+			return result;
+		}
+	}
+
+	QJsonObject benchmarkBoneEvaluation(uint32_t iterations, bool& matches_recursive) {
+		constexpr std::array<uint32_t, 4> bone_counts = { 16, 64, 256, 1024 };
+		const uint32_t frames = iterations * 100;
+
+		matches_recursive = true;
+
+		QJsonArray results;
+		for (const auto bone_count : bone_counts) {
+			results.push_back(compare<TIMELINE_VERSION>(bone_count, frames, matches_recursive));
+			results.push_back(compare<RANGE_VERSION>(bone_count, frames, matches_recursive));
+		}
+
+		QJsonObject report;
+		report["frames"] = (qint64)frames;
+		report["matches_recursive"] = matches_recursive;
+		report["results"] = results;
+		return report;
+	}
+};
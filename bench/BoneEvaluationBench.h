@@ -0,0 +1,11 @@
+#pragma once
+
+#include <QJsonObject>
+#include <cstdint>
+
+namespace bench {
+
+	// compares the recursive per bone calculateMatrix walk models used to do against GenericModelBoneEvaluator, on generated skeletons.
+	// both timeline (wotlk+) and range based (pre wotlk) tracks are covered, the resulting matrices must be bitwise identical.
+	QJsonObject benchmarkBoneEvaluation(uint32_t iterations, bool& matches_recursive);
+};
@@ -0,0 +1,183 @@
+#include "stdafx.h"
+#include "FileSystemStress.h"
+#include <QByteArray>
+#include <QJsonArray>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <thread>
+
+namespace bench {
+
+	using namespace core;
+
+	namespace {
+
+		struct Reference {
+			GameFileUri uri;
+			QByteArray content;
+		};
+
+		bool matches(const Reference& reference, std::span<const uint8_t> content) {
+			return content.size() == (size_t)reference.content.size() &&
+				(content.empty() || memcmp(content.data(), reference.content.constData(), content.size()) == 0);
+		}
+
+		// reads the file in chunks of varying size, as the model and database readers do.
+		bool readChunked(ArchiveFile* file, const Reference& reference, std::mt19937& rng) {
+			const uint64_t size = file->getFileSize();
+			if (size != (uint64_t)reference.content.size()) {
+				return false;
+			}
+
+			std::vector<uint8_t> chunk;
+			uint64_t offset = 0;
+			while (offset < size) {
+				const uint64_t bytes = std::min<uint64_t>(size - offset, 1 + rng() % (64 * 1024));
+				chunk.resize(bytes);
+				file->read(chunk.data(), bytes, offset);
+
+				if (memcmp(chunk.data(), reference.content.constData() + offset, bytes) != 0) {
+					return false;
+				}
+
+				offset += bytes;
+			}
+
+			return true;
+		}
+
+		bool readPartial(ArchiveFile* file, const Reference& reference, std::mt19937& rng) {
+			const uint64_t size = file->getFileSize();
+			if (size != (uint64_t)reference.content.size()) {
+				return false;
+			}
+
+			if (size == 0) {
+				return true;
+			}
+
+			const uint64_t offset = rng() % size;
+			const uint64_t bytes = 1 + rng() % (size - offset);
+			std::vector<uint8_t> buffer(bytes);
+			file->read(buffer.data(), bytes, offset);
+
+			return memcmp(buffer.data(), reference.content.constData() + offset, bytes) == 0;
+		}
+	}
+
+	QJsonObject stressFileSystem(GameFileSystem* fs, const std::vector<GameFileUri>& uris, uint32_t threads, uint32_t rounds, bool& passed) {
+		constexpr size_t BATCH_SIZE = 8;
+
+		std::vector<Reference> references;
+		QJsonArray unavailable;
+
+		for (const auto& uri : uris) {
+			auto file = fs->openFile(uri);
+			if (file == nullptr) {
+				unavailable.push_back(uri.toString());
+				continue;
+			}
+
+			const auto content = file->data();
+			references.push_back({ uri, QByteArray((const char*)content.data(), content.size()) });
+		}
+
+		std::atomic<uint64_t> operations{ 0 };
+		std::atomic<uint64_t> errors{ 0 };
+
+		const auto start = std::chrono::steady_clock::now();
+
+		std::vector<std::thread> workers;
+		workers.reserve(threads);
+
+		for (uint32_t t = 0; t < threads; t++) {
+			workers.emplace_back([&, t]() {
+				std::mt19937 rng(t + 1);
+				std::vector<size_t> order(references.size());
+				for (size_t i = 0; i < order.size(); i++) {
+					order[i] = i;
+				}
+
+				for (uint32_t round = 0; round < rounds; round++) {
+					// every thread works through the files in a different order, so the same file is often open on several threads at once.
+					std::shuffle(order.begin(), order.end(), rng);
+
+					for (size_t i = 0; i < order.size(); i++) {
+						const auto& reference = references[order[i]];
+						bool ok = false;
+
+						try {
+							switch ((i + t) % 4) {
+							case 0:
+							{
+								auto file = fs->openFile(reference.uri);
+								ok = file != nullptr && matches(reference, file->data());
+							}
+							break;
+							case 1:
+							{
+								auto file = fs->openFile(reference.uri);
+								ok = file != nullptr && readChunked(file.get(), reference, rng);
+							}
+							break;
+							case 2:
+							{
+								auto file = fs->openFile(reference.uri);
+								ok = file != nullptr && readPartial(file.get(), reference, rng);
+							}
+							break;
+							default:
+							{
+								std::vector<size_t> batch;
+								std::vector<GameFileUri> batch_uris;
+								for (size_t b = 0; b < BATCH_SIZE; b++) {
+									batch.push_back(order[(i + b) % order.size()]);
+									batch_uris.push_back(references[batch.back()].uri);
+								}
+
+								auto files = fs->openFiles(batch_uris);
+								ok = true;
+								for (size_t b = 0; b < files.size(); b++) {
+									auto file = files[b].get();
+									ok = ok && file != nullptr && matches(references[batch[b]], file->data());
+								}
+							}
+							break;
+							}
+						}
+						catch (const std::exception&) {
+							ok = false;
+						}
+
+						operations++;
+						if (!ok) {
+							errors++;
+						}
+					}
+				}
+			});
+		}
+
+		for (auto& worker : workers) {
+			worker.join();
+		}
+
+		const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		passed = references.size() > 0 && errors == 0;
+
+		QJsonObject result;
+		result["files"] = (qint64)references.size();
+		result["unavailable"] = unavailable;
+		result["threads"] = (qint64)threads;
+		result["rounds"] = (qint64)rounds;
+		result["operations"] = (qint64)operations.load();
+		result["errors"] = (qint64)errors.load();
+		result["elapsed_ms"] = elapsed;
+		result["passed"] = passed;
+		return result;
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <QJsonObject>
+#include <cstdint>
+#include <vector>
+#include "core/filesystem/GameFileSystem.h"
+
+namespace bench {
+
+	// opens and reads the files from many threads at once, through openFile + data(), chunked read(), partial read() and openFiles.
+	// every read is compared against the content read single threaded beforehand, any mismatch, exception or failed open is an error.
+	QJsonObject stressFileSystem(core::GameFileSystem* fs, const std::vector<core::GameFileUri>& uris, uint32_t threads, uint32_t rounds, bool& passed);
+};
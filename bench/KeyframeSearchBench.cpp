@@ -0,0 +1,228 @@
+#include "stdafx.h"
+#include "KeyframeSearchBench.h"
+#include "core/modeling/Animation.h"
+#include <QJsonArray>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace bench {
+
+	using namespace core;
+
+	namespace {
+
+		// the search TimelineBasedAnimatedValue / RangeBasedAnimatedValue did before KeyframeCursor.
+		size_t findLinear(std::span<const uint32_t> times, uint32_t time) {
+			size_t pos = 0;
+			for (size_t i = 0; i < times.size() - 1; i++) {
+				if (time >= times[i] && time < times[i + 1]) {
+					pos = i;
+					break;
+				}
+			}
+			return pos;
+		}
+
+		// the value RangeBasedAnimatedValue returned before KeyframeCursor, scanning every key of the track rather than the range.
+		// where the scan found no segment (a time on the final key) it fell back to key 0, the final key is now returned instead.
+		float rangeValueLinear(const std::vector<uint32_t>& timestamps, const std::vector<float>& data, const AnimationRange& range, Interpolation interpolation, uint32_t frame) {
+			const size_t max_time = timestamps[range.end];
+			const uint32_t time = timestamps[range.start] + frame;
+
+			if (time > max_time) {
+				return data[timestamps.size() - 1];
+			}
+
+			for (size_t i = 0; i < timestamps.size() - 1; i++) {
+				if (time >= timestamps[i] && time < timestamps[i + 1]) {
+					const float r = (time - timestamps[i]) / (float)(timestamps[i + 1] - timestamps[i]);
+					return interpolation == INTERPOLATION_NONE ? data[i] : interpolate<float>(r, data[i], data[i + 1]);
+				}
+			}
+
+			return data.back();
+		}
+
+		// keys start at 0 and are 1 - 66ms apart, roughly what exported tracks use.
+		std::vector<uint32_t> generateTimes(uint32_t key_count, uint32_t seed) {
+			std::mt19937 rng(seed);
+			std::vector<uint32_t> times(key_count);
+			uint32_t time = 0;
+			for (auto& value : times) {
+				value = time;
+				time += 1 + rng() % 66;
+			}
+			return times;
+		}
+
+		// times the animated values pass to the search, so always before the last key.
+		std::vector<uint32_t> generatePlayback(const std::vector<uint32_t>& times, uint32_t count) {
+			std::vector<uint32_t> lookups(count);
+			uint32_t time = 0;
+			for (auto& value : lookups) {
+				value = time;
+				time = (time + 16) % times.back();
+			}
+			return lookups;
+		}
+
+		std::vector<uint32_t> generateRandom(const std::vector<uint32_t>& times, uint32_t count, uint32_t seed) {
+			std::mt19937 rng(seed);
+			std::vector<uint32_t> lookups(count);
+			for (auto& value : lookups) {
+				value = rng() % times.back();
+			}
+			return lookups;
+		}
+
+		// animations of 1 - 32 keys on a single timeline, every 4th starting at the same time the previous one ended.
+		RangeBasedAnimationBlock<float> generateRanges(uint32_t key_count, uint32_t seed) {
+			std::mt19937 rng(seed);
+			std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+			RangeBasedAnimationBlock<float> block;
+			block.globalSequence = -1;
+
+			uint32_t time = 0;
+			while (block.timestamps.size() < key_count) {
+				if (!block.timestamps.empty()) {
+					time = block.timestamps.back() + (rng() % 4 == 0 ? 0 : 1 + rng() % 100);
+				}
+
+				const uint32_t keys = 1 + rng() % 32;
+				block.ranges.push_back(AnimationRange{ (uint32_t)block.timestamps.size(), (uint32_t)block.timestamps.size() + keys - 1 });
+
+				for (uint32_t i = 0; i < keys; i++) {
+					block.timestamps.push_back(time);
+					block.keys.push_back(dist(rng));
+					time += 1 + rng() % 66;
+				}
+			}
+
+			return block;
+		}
+
+		// every key of every range, the midpoint after it and one frame past the end.
+		std::vector<std::pair<size_t, uint32_t>> generateRangeLookups(const RangeBasedAnimationBlock<float>& block) {
+			std::vector<std::pair<size_t, uint32_t>> lookups;
+			for (size_t animation = 0; animation < block.ranges.size(); animation++) {
+				const auto& range = block.ranges[animation];
+				const auto start_time = block.timestamps[range.start];
+				for (uint32_t i = range.start; i <= range.end; i++) {
+					lookups.emplace_back(animation, block.timestamps[i] - start_time);
+					if (i < range.end) {
+						lookups.emplace_back(animation, (block.timestamps[i] + block.timestamps[i + 1]) / 2 - start_time);
+					}
+				}
+				lookups.emplace_back(animation, block.timestamps[range.end] - start_time + 1);
+			}
+			return lookups;
+		}
+
+		template<typename L, typename C, typename fn>
+		double nanosecondsPerLookup(const std::vector<L>& lookups, uint32_t iterations, C& checksum, fn find) {
+			const auto start = std::chrono::steady_clock::now();
+			for (uint32_t i = 0; i < iterations; i++) {
+				for (const auto time : lookups) {
+					checksum += find(time);
+				}
+			}
+			const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+			return elapsed.count() / std::max<double>(1.0, (double)lookups.size() * iterations);
+		}
+	}
+
+	QJsonObject benchmarkKeyframeSearch(uint32_t iterations, bool& matches_linear) {
+		constexpr std::array<uint32_t, 6> key_counts = { 2, 8, 32, 128, 512, 2048 };
+		constexpr uint32_t LOOKUPS = 4096;
+
+		matches_linear = true;
+
+		QJsonArray results;
+
+		for (const auto key_count : key_counts) {
+			const auto times = generateTimes(key_count, key_count);
+
+			const std::array<std::pair<QString, std::vector<uint32_t>>, 2> patterns = { {
+				{ "playback", generatePlayback(times, LOOKUPS) },
+				{ "random", generateRandom(times, LOOKUPS, key_count + 1) }
+			} };
+
+			for (const auto& [pattern, lookups] : patterns) {
+				KeyframeCursor cursor;
+				for (const auto time : lookups) {
+					matches_linear &= cursor.find(times, time) == findLinear(times, time);
+				}
+
+				size_t linear_checksum = 0, cursor_checksum = 0;
+
+				QJsonObject result;
+				result["keys"] = (qint64)key_count;
+				result["pattern"] = pattern;
+				result["linear_ns"] = nanosecondsPerLookup(lookups, iterations, linear_checksum, [&](uint32_t time) {
+					return findLinear(times, time);
+				});
+				result["cursor_ns"] = nanosecondsPerLookup(lookups, iterations, cursor_checksum, [&](uint32_t time) {
+					return cursor.find(times, time);
+				});
+				result["speedup"] = result["linear_ns"].toDouble() / std::max(1e-3, result["cursor_ns"].toDouble());
+
+				matches_linear &= linear_checksum == cursor_checksum;
+				results.push_back(result);
+			}
+		}
+
+		// range based tracks (pre wotlk), whole values are compared as the range bounds changed along with the search.
+		for (const auto key_count : key_counts) {
+			for (const auto interpolation : { INTERPOLATION_NONE, INTERPOLATION_LINEAR }) {
+				auto block = generateRanges(key_count, key_count);
+				block.interpolationType = interpolation;
+
+				const auto timestamps = block.timestamps;
+				const auto data = block.keys;
+				const auto ranges = block.ranges;
+				const auto lookups = generateRangeLookups(block);
+
+				auto value = RangeBasedAnimatedValue<float>::make(std::move(block), std::make_shared<std::vector<uint32_t>>(), [](auto&& val) { return val; });
+
+				auto linear = [&](const std::pair<size_t, uint32_t>& lookup) {
+					return rangeValueLinear(timestamps, data, ranges[lookup.first], interpolation, lookup.second);
+				};
+				auto cursor = [&](const std::pair<size_t, uint32_t>& lookup) {
+					return value.getValue(lookup.first, AnimationTickArgs(lookup.second));
+				};
+
+				for (const auto& lookup : lookups) {
+					const float expected = linear(lookup);
+					const float actual = cursor(lookup);
+					matches_linear &= memcmp(&expected, &actual, sizeof(float)) == 0;
+				}
+
+				double linear_checksum = 0, cursor_checksum = 0;
+
+				QJsonObject result;
+				result["keys"] = (qint64)timestamps.size();
+				result["pattern"] = interpolation == INTERPOLATION_NONE ? "range_none" : "range_linear";
+				result["linear_ns"] = nanosecondsPerLookup(lookups, iterations, linear_checksum, linear);
+				result["cursor_ns"] = nanosecondsPerLookup(lookups, iterations, cursor_checksum, cursor);
+				result["speedup"] = result["linear_ns"].toDouble() / std::max(1e-3, result["cursor_ns"].toDouble());
+
+				matches_linear &= linear_checksum == cursor_checksum;
+				results.push_back(result);
+			}
+		}
+
+		QJsonObject report;
+		report["iterations"] = (qint64)iterations;
+		report["lookups"] = (qint64)LOOKUPS;
+		report["matches_linear"] = matches_linear;
+		report["results"] = results;
+		return report;
+	}
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <QJsonObject>
+#include <cstdint>
+
+namespace bench {
+
+	// compares the linear keyframe scan the animated values used to do against KeyframeCursor, on generated tracks of increasing length.
+	// lookups follow frame by frame playback and random seeking, every result is checked against the linear scan.
+	// range based values are checked on every key and range boundary, against the value the old scan over the whole timeline produced.
+	QJsonObject benchmarkKeyframeSearch(uint32_t iterations, bool& matches_linear);
+};
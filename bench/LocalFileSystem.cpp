@@ -0,0 +1,134 @@
+#include "stdafx.h"
+#include "LocalFileSystem.h"
+#include "core/utility/Exceptions.h"
+#include <QDir>
+#include <QDirIterator>
+
+namespace bench {
+
+	using namespace core;
+
+	uint64_t LocalFile::getFileSize() {
+		return _file->size();
+	}
+
+	void LocalFile::read(void* dest, uint64_t bytes, uint64_t offset) {
+		if (!_file->seek(offset) || _file->read(static_cast<char*>(dest), bytes) != (qint64)bytes) {
+			throw FileIOException(_uri.toString().toStdString(), "Unable to read file.");
+		}
+	}
+
+	LocalFileSystem::LocalFileSystem(const QString& root, const QString& list_file) : GameFileSystem(root, ""), listFilePath(list_file)
+	{
+	}
+
+	std::future<void> LocalFileSystem::load()
+	{
+		if (!listFilePath.isEmpty()) {
+			listFile = ListFileIndex::open(listFilePath);
+		}
+
+		return std::future<void>();
+	}
+
+	std::unique_ptr<ArchiveFile> LocalFileSystem::openFile(const GameFileUri& uri)
+	{
+		std::optional<QString> path;
+		if (uri.isId()) {
+			path = findPath(uri.getId());
+		}
+		else {
+			path = uri.getPath();
+		}
+
+		if (!path.has_value() || path->isEmpty()) {
+			return nullptr;
+		}
+
+		// game paths use either separator and are case insensitive, extracted files are commonly lowercase.
+		const QString relative = QString(*path).replace('\\', '/');
+
+		for (const auto& candidate : { relative, relative.toLower() }) {
+			auto file = std::make_unique<QFile>(QDir(rootDirectory).filePath(candidate));
+			if (file->open(QIODevice::ReadOnly)) {
+				return std::make_unique<LocalFile>(uri, std::move(file));
+			}
+		}
+
+		return nullptr;
+	}
+
+	std::unique_ptr<std::vector<GameFileUri::path_t>> LocalFileSystem::fileList(std::function<bool(const GameFileUri::path_t&)> pred)
+	{
+		auto list_items = std::make_unique<std::vector<GameFileUri::path_t>>();
+		const QDir root(rootDirectory);
+
+		QDirIterator it(rootDirectory, QDir::Files, QDirIterator::Subdirectories);
+		while (it.hasNext()) {
+			auto name = root.relativeFilePath(it.next());
+			if (pred(name)) {
+				list_items->push_back(std::move(name));
+			}
+		}
+
+		return list_items;
+	}
+
+	GameFileUri LocalFileSystem::asFileId(const GameFileUri& uri) const
+	{
+		if (uri.isPath()) {
+			return listFile.findId(uri.getPath()).value_or(0);
+		}
+
+		return uri;
+	}
+
+	GameFileUri LocalFileSystem::asFilePath(const GameFileUri& uri) const
+	{
+		if (uri.isId()) {
+			return findPath(uri.getId()).value_or("");
+		}
+
+		return uri;
+	}
+
+	GameFileUri LocalFileSystem::asInternal(const GameFileUri& uri) const
+	{
+		return asFilePath(uri);
+	}
+
+	GameFileUri LocalFileSystem::asInternal(const GameFileInfo& info) const
+	{
+		if (!info.path.isEmpty()) {
+			return info.path;
+		}
+
+		return info.id;
+	}
+
+	GameFileInfo LocalFileSystem::asInfo(const GameFileUri& uri) const
+	{
+		auto info = GameFileInfo();
+
+		if (uri.isId()) {
+			info.id = uri.getId();
+			info.path = findPath(info.id).value_or("");
+		}
+		else {
+			info.path = uri.getPath();
+			info.id = listFile.findId(info.path).value_or(0);
+		}
+
+		return info;
+	}
+
+	std::optional<QString> LocalFileSystem::findPath(GameFileUri::id_t id) const
+	{
+		const auto path = listFile.findPath(id);
+		if (path.has_value()) {
+			return QString::fromUtf8(path->data(), path->size());
+		}
+
+		return std::nullopt;
+	}
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <memory>
+#include <optional>
+#include "core/filesystem/GameFileSystem.h"
+#include "core/filesystem/ListFileIndex.h"
+
+namespace bench {
+
+	class LocalFile final : public core::ArchiveFile {
+	public:
+		LocalFile(const core::GameFileUri& uri, std::unique_ptr<QFile> file) :
+			ArchiveFile(uri), _file(std::move(file))
+		{}
+
+		uint64_t getFileSize() override;
+		void read(void* dest, uint64_t bytes, uint64_t offset = 0) override;
+
+		// only database readers release files, the benchmark never loads a database.
+		std::unique_ptr<WDBReader::Filesystem::FileSource> release() override {
+			return nullptr;
+		}
+
+	protected:
+		std::unique_ptr<QFile> _file;
+	};
+
+	/// <summary>
+	/// Stand-in for a game client, reading files previously extracted to a directory.
+	/// File ids are resolved through an optional listfile, paths are matched as given or lowercase.
+	/// </summary>
+	class LocalFileSystem final : public core::GameFileSystem {
+	public:
+		LocalFileSystem(const QString& root, const QString& list_file);
+		LocalFileSystem(LocalFileSystem&&) = delete;
+		virtual ~LocalFileSystem() {
+			waitForOpens();
+		}
+
+		constexpr QChar seperator() const override {
+			return '/';
+		}
+
+		std::future<void> load() override;
+
+		std::unique_ptr<core::ArchiveFile> openFile(const core::GameFileUri& uri) override;
+		std::unique_ptr<std::vector<core::GameFileUri::path_t>> fileList(std::function<bool(const core::GameFileUri::path_t&)> pred) override;
+
+		core::GameFileUri asFileId(const core::GameFileUri& uri) const override;
+		core::GameFileUri asFilePath(const core::GameFileUri& uri) const override;
+		core::GameFileUri asInternal(const core::GameFileUri& uri) const override;
+		core::GameFileUri asInternal(const core::GameFileInfo& info) const override;
+		core::GameFileInfo asInfo(const core::GameFileUri& uri) const override;
+
+	protected:
+		std::optional<QString> findPath(core::GameFileUri::id_t id) const;
+
+		QString listFilePath;
+		core::ListFileIndex listFile;
+	};
+};
@@ -0,0 +1,252 @@
+#include "stdafx.h"
+#include "SkinningBench.h"
+#include "core/modeling/VertexSkinning.h"
+#include <QJsonArray>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace bench {
+
+	using namespace core;
+
+	namespace {
+
+		// fma rounds once per multiply add, model units are yards so this is far below anything visible.
+		constexpr float FMA_TOLERANCE = 1e-4f;
+
+		constexpr std::array<VertexSkinning::Kernel, 3> kernels = {
+			VertexSkinning::Kernel::SCALAR,
+			VertexSkinning::Kernel::SSE2,
+			VertexSkinning::Kernel::AVX2
+		};
+
+		QString kernelName(VertexSkinning::Kernel kernel) {
+			switch (kernel) {
+			case VertexSkinning::Kernel::SSE2:
+				return "sse2";
+			case VertexSkinning::Kernel::AVX2:
+				return "avx2";
+			default:
+				return "scalar";
+			}
+		}
+
+		// fixed matrices, skinning only reads getMat / getMRot.
+		class PaletteBone : public ModelBoneAdaptor {
+		public:
+			PaletteBone(const Matrix& mat, const Matrix& mrot) : mat(mat), mrot(mrot) {}
+
+			std::unique_ptr<ModelBoneAdaptor> clone() const override {
+				return std::make_unique<PaletteBone>(*this);
+			}
+
+			const IAnimatedValue<Vector3>* getTranslation() const override {
+				return nullptr;
+			}
+			const IAnimatedValue<Quaternion>* getRotation() const override {
+				return nullptr;
+			}
+			const IAnimatedValue<Vector3>* getScale() const override {
+				return nullptr;
+			}
+
+			void calculateMatrix(size_t animation_index, const AnimationTickArgs& tick, std::vector<ModelBoneAdaptor*>& allbones) override {}
+
+			const Matrix& getMat() const override {
+				return mat;
+			}
+			const Matrix& getMRot() const override {
+				return mrot;
+			}
+
+			const Vector3& getTranslationPivot() const override {
+				return pivot;
+			}
+			const Vector3& getPivot() const override {
+				return pivot;
+			}
+
+			int16_t getParentBoneId() const override {
+				return -1;
+			}
+
+			void resetCalculated() override {}
+
+		protected:
+			Matrix mat;
+			Matrix mrot;
+			Vector3 pivot;
+		};
+
+		std::vector<std::unique_ptr<PaletteBone>> generateBones(uint32_t bone_count, std::mt19937& rng) {
+			std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+			std::uniform_real_distribution<float> offset(-10.0f, 10.0f);
+
+			std::vector<std::unique_ptr<PaletteBone>> bones;
+			bones.reserve(bone_count);
+
+			for (uint32_t i = 0; i < bone_count; i++) {
+				const Quaternion q(unit(rng), unit(rng), unit(rng), unit(rng));
+				const float length = std::sqrt((q.x * q.x) + (q.y * q.y) + (q.z * q.z) + (q.w * q.w));
+				const Quaternion rotation = length > 0.001f ? Quaternion(q.x / length, q.y / length, q.z / length, q.w / length) : Quaternion();
+
+				const Matrix mrot = Matrix::newQuatRotate(rotation);
+				const Matrix mat = Matrix::newTranslation(Vector3(offset(rng), offset(rng), offset(rng))) * mrot;
+				bones.push_back(std::make_unique<PaletteBone>(mat, mrot));
+			}
+
+			return bones;
+		}
+
+		// 0 - 4 influences per vertex, about 1 in 64 referencing a bone past the end of the model.
+		std::vector<ModelVertexM2> generateVertices(uint32_t vertex_count, uint32_t bone_count, std::mt19937& rng) {
+			std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+
+			std::vector<ModelVertexM2> vertices(vertex_count);
+			for (auto& vert : vertices) {
+				vert = {};
+				vert.position = Vector3(position(rng), position(rng), position(rng));
+				vert.normal = Vector3(position(rng), position(rng), position(rng));
+
+				const auto influences = rng() % (ModelVertexM2::BONE_COUNT + 1);
+				for (size_t b = 0; b < influences; b++) {
+					vert.bones[b] = rng() % 64 == 0 ? (uint8_t)(bone_count + rng() % 8) : (uint8_t)(rng() % bone_count);
+					vert.boneWeights[b] = (uint8_t)(1 + rng() % 255);
+				}
+			}
+
+			return vertices;
+		}
+
+		// the loop models ran before VertexSkinning, with the out of range check it now documents.
+		void skinReference(const std::vector<ModelVertexM2>& vertices, const std::vector<const ModelBoneAdaptor*>& bones, std::vector<Vector3>& out_vertices, std::vector<Vector3>& out_normals) {
+			auto index = 0;
+			for (auto& orgVert : vertices) {
+				const Vector3 position = Vector3::yUpToZUp(orgVert.position);
+				const Vector3 normal = Vector3::yUpToZUp(orgVert.normal).normalize();
+
+				Vector3 v = Vector3(0, 0, 0);
+				Vector3 n = Vector3(0, 0, 0);
+
+				for (size_t b = 0; b < ModelVertexM2::BONE_COUNT; b++)
+				{
+					if (orgVert.boneWeights[b] > 0 && orgVert.bones[b] < bones.size()) {
+						const auto& adaptor = bones[orgVert.bones[b]];
+						Vector3 tv = adaptor->getMat() * position;
+						Vector3 tn = adaptor->getMRot() * normal;
+						v += tv * ((float)orgVert.boneWeights[b] / 255.0f);
+						n += tn * ((float)orgVert.boneWeights[b] / 255.0f);
+					}
+				}
+
+				out_vertices[index] = v;
+				out_normals[index] = n;
+				index++;
+			}
+		}
+
+		float maxError(const std::vector<Vector3>& actual, const std::vector<Vector3>& expected) {
+			float error = 0.f;
+			for (size_t i = 0; i < actual.size(); i++) {
+				const float a[3] = { actual[i].x, actual[i].y, actual[i].z };
+				const float e[3] = { expected[i].x, expected[i].y, expected[i].z };
+				for (size_t c = 0; c < 3; c++) {
+					error = std::max(error, std::abs(a[c] - e[c]) / std::max(1.0f, std::abs(e[c])));
+				}
+			}
+			return error;
+		}
+
+		template<typename fn>
+		double microsecondsPerUpdate(uint32_t iterations, fn callback) {
+			const auto start = std::chrono::steady_clock::now();
+			for (uint32_t i = 0; i < iterations; i++) {
+				callback();
+			}
+			const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+			return elapsed.count() / iterations;
+		}
+	}
+
+	QJsonObject benchmarkSkinning(uint32_t iterations, bool& matches_reference) {
+		constexpr std::array<uint32_t, 4> vertex_counts = { 1, 100, 5000, 50000 };
+		constexpr uint32_t bone_count = 200;
+
+		matches_reference = true;
+
+		QJsonArray results;
+
+		for (const auto vertex_count : vertex_counts) {
+			std::mt19937 rng(vertex_count);
+			const auto bone_owners = generateBones(bone_count, rng);
+			const auto vertices = generateVertices(vertex_count, bone_count, rng);
+
+			std::vector<const ModelBoneAdaptor*> bones;
+			for (const auto& bone : bone_owners) {
+				bones.push_back(bone.get());
+			}
+
+			std::vector<Vector3> expected_vertices(vertex_count), expected_normals(vertex_count);
+			std::vector<Vector3> actual_vertices(vertex_count), actual_normals(vertex_count);
+
+			skinReference(vertices, bones, expected_vertices, expected_normals);
+
+			VertexSkinning skinning;
+			skinning.init(vertices, bone_count);
+
+			QJsonObject result;
+			result["vertices"] = (qint64)vertex_count;
+			result["bones"] = (qint64)bone_count;
+			result["reference_us"] = microsecondsPerUpdate(iterations, [&]() {
+				skinReference(vertices, bones, actual_vertices, actual_normals);
+			});
+
+			QJsonObject kernel_results;
+			for (const auto kernel : kernels) {
+				if (!VertexSkinning::supported(kernel)) {
+					continue;
+				}
+
+				std::fill(actual_vertices.begin(), actual_vertices.end(), Vector3(-1, -1, -1));
+				std::fill(actual_normals.begin(), actual_normals.end(), Vector3(-1, -1, -1));
+				skinning.update(bones, actual_vertices, actual_normals, kernel);
+
+				const float error = std::max(maxError(actual_vertices, expected_vertices), maxError(actual_normals, expected_normals));
+				bool matches = false;
+				if (kernel == VertexSkinning::Kernel::AVX2) {
+					matches = error <= FMA_TOLERANCE;
+				}
+				else {
+					matches = memcmp(actual_vertices.data(), expected_vertices.data(), vertex_count * sizeof(Vector3)) == 0 &&
+						memcmp(actual_normals.data(), expected_normals.data(), vertex_count * sizeof(Vector3)) == 0;
+				}
+				matches_reference &= matches;
+
+				QJsonObject kernel_result;
+				kernel_result["matches_reference"] = matches;
+				kernel_result["max_error"] = error;
+				kernel_result["us"] = microsecondsPerUpdate(iterations, [&]() {
+					skinning.update(bones, actual_vertices, actual_normals, kernel);
+				});
+				kernel_result["speedup"] = result["reference_us"].toDouble() / std::max(1e-3, kernel_result["us"].toDouble());
+				kernel_results[kernelName(kernel)] = kernel_result;
+			}
+
+			result["kernels"] = kernel_results;
+			results.push_back(result);
+		}
+
+		QJsonObject report;
+		report["kernel"] = kernelName(VertexSkinning::kernel());
+		report["iterations"] = (qint64)iterations;
+		report["fma_tolerance"] = FMA_TOLERANCE;
+		report["matches_reference"] = matches_reference;
+		report["results"] = results;
+		return report;
+	}
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <QJsonObject>
+#include <cstdint>
+
+namespace bench {
+
+	// skins generated meshes with each VertexSkinning kernel supported by the cpu, comparing against the old per vertex loop.
+	// scalar and sse2 must be bitwise identical, avx2 (fma) must be within 1e-4 of the reference, relative to values above 1.
+	QJsonObject benchmarkSkinning(uint32_t iterations, bool& matches_reference);
+};
@@ -0,0 +1,719 @@
+#include "stdafx.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QThread>
+#include <WDBReader/Detection.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <new>
+#include <optional>
+#include "core/filesystem/CachedFileSystem.h"
+#include "core/filesystem/CascFileSystem.h"
+#include "core/filesystem/ListFileIndex.h"
+#include "core/game/GameClientAdaptor.h"
+#include "core/modeling/Animator.h"
+#include "core/modeling/M2.h"
+#include "core/modeling/Texture.h"
+#include "core/modeling/VertexSkinning.h"
+#include "core/utility/Logger.h"
+#include "BlockDecoderBench.h"
+#include "BoneEvaluationBench.h"
+#include "FileSystemStress.h"
+#include "KeyframeSearchBench.h"
+#include "LocalFileSystem.h"
+#include "SkinningBench.h"
+
+/*
+* Headless benchmark of model loading and animation, no window or GL context is created.
+* Usage: WMVxBench (--game <dir> | --files <dir> [--listfile <csv>]) [--iterations n] [--frames n] [--output file.json] <model>...
+* Models may also be read from a file with --models, one path (or file id) per line.
+* Paths ending in .blp are benchmarked as textures, using the same decode stage as the texture manager (no GL calls are made).
+* WMVxBench --decode [--iterations n] benchmarks texture block decoding instead, without any game files.
+* WMVxBench --keyframes [--iterations n] compares the keyframe search against the linear scan it replaced, without any game files.
+* WMVxBench --bones [--iterations n] compares the bone evaluator against the recursive per bone walk it replaced, without any game files.
+* WMVxBench --skinning [--iterations n] compares each supported skinning kernel against the per vertex loop it replaced, without any game files.
+* WMVxBench --parse-listfile --listfile <csv> [--iterations n] compares building the listfile index serially and in parallel.
+* WMVxBench (--game <dir> | --files <dir>) --stress [--threads n] [--iterations n] <files...> checks concurrent opens and reads,
+* against the backend itself and behind CachedFileSystem.
+* WMVxBench --game <dir> --disk-cache <dir> <files...> checks that files read in one session are served from the casc disk cache in the next.
+*/
+
+namespace {
+	std::atomic<uint64_t> allocationCount{ 0 };
+}
+
+void* operator new(std::size_t size) {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (void* ptr = std::malloc(size > 0 ? size : 1)) {
+		return ptr;
+	}
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+namespace bench {
+
+	using namespace core;
+	using clock = std::chrono::steady_clock;
+
+	class Samples {
+	public:
+		template<typename fn>
+		void measure(fn callback) {
+			const auto allocations = allocationCount.load(std::memory_order_relaxed);
+			const auto start = clock::now();
+			callback();
+			const auto end = clock::now();
+
+			timings.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+			allocationTotal += allocationCount.load(std::memory_order_relaxed) - allocations;
+		}
+
+		QJsonObject toJson() const {
+			QJsonObject result;
+			result["samples"] = (qint64)timings.size();
+
+			if (timings.size() > 0) {
+				double total = 0;
+				for (const auto t : timings) {
+					total += t;
+				}
+
+				result["p50_us"] = percentile(0.50);
+				result["p99_us"] = percentile(0.99);
+				result["mean_us"] = total / timings.size();
+				result["allocations_per_sample"] = (double)allocationTotal / timings.size();
+			}
+
+			return result;
+		}
+
+	protected:
+		double percentile(double p) const {
+			auto sorted = timings;
+			const auto index = std::min<size_t>(sorted.size() - 1, (size_t)(p * (sorted.size() - 1) + 0.5));
+			std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+			return sorted[index];
+		}
+
+		std::vector<double> timings;
+		uint64_t allocationTotal = 0;
+	};
+
+	struct Options {
+		uint32_t iterations = 10;
+		uint32_t frames = 300;
+		uint32_t frameDelta = 16;
+	};
+
+	QJsonObject benchmarkModel(GameFileSystem* fs, const GameFileUri& uri, const Options& options) {
+		Samples load, bones, skinning, particles;
+		size_t vertex_count = 0, bone_count = 0, emitter_count = 0;
+
+		for (uint32_t iteration = 0; iteration < options.iterations; iteration++) {
+			std::unique_ptr<M2Model> model;
+			std::optional<size_t> animation_index;
+
+			// the shared model cache is bypassed, so every iteration parses the file.
+			load.measure([&]() {
+				model = std::make_unique<M2Model>(M2Data::load(fs, uri));
+
+				const auto& sequences = model->getModelAnimationSequenceAdaptors();
+				const auto stand = std::find_if(sequences.begin(), sequences.end(), [](const auto* seq) {
+					return seq->getId() == 0 && seq->getVariationId() == 0;
+				});
+
+				if (stand != sequences.end()) {
+					animation_index = std::distance(sequences.begin(), stand);
+				}
+				else if (sequences.size() > 0) {
+					animation_index = 0;
+				}
+
+				if (animation_index.has_value()) {
+					model->loadAnimation(animation_index.value());
+				}
+			});
+
+			vertex_count = model->getVertices().size();
+			bone_count = model->getBoneAdaptors().size();
+			emitter_count = model->getParticleAdaptors().size() + model->getRibbonAdaptors().size();
+
+			if (!animation_index.has_value()) {
+				continue;
+			}
+
+			Animator animator;
+			animator.setAnimation(model->getModelAnimationSequenceAdaptors()[animation_index.value()], animation_index.value());
+
+			VertexSkinning vertex_skinning;
+			std::vector<Vector3> animated_vertices = model->getVertices();
+			std::vector<Vector3> animated_normals = model->getNormals();
+			if (bone_count > 0) {
+				vertex_skinning.init(model->getRawVertices(), bone_count);
+			}
+
+			for (uint32_t frame = 0; frame < options.frames; frame++) {
+				const AnimationTickArgs& tick = animator.tick(options.frameDelta);
+
+				bones.measure([&]() {
+					model->calculateBones(animation_index.value(), tick);
+				});
+
+				if (bone_count > 0) {
+					skinning.measure([&]() {
+						vertex_skinning.update(model->getBoneAdaptors(), animated_vertices, animated_normals);
+					});
+				}
+
+				if (emitter_count > 0) {
+					particles.measure([&]() {
+						model->updateParticles(animation_index.value(), tick);
+						model->updateRibbons(animation_index.value(), tick);
+					});
+				}
+			}
+		}
+
+		QJsonObject result;
+		result["model"] = uri.toString();
+		result["vertices"] = (qint64)vertex_count;
+		result["bones"] = (qint64)bone_count;
+		result["emitters"] = (qint64)emitter_count;
+		result["load"] = load.toJson();
+		result["bone_evaluation"] = bones.toJson();
+		result["skinning"] = skinning.toJson();
+		result["particles"] = particles.toJson();
+		return result;
+	}
+
+	QJsonObject benchmarkTexture(GameFileSystem* fs, const GameFileUri& uri, const Options& options) {
+		Samples decode, decode_compressed;
+		DecodedTexture decoded;
+
+		for (uint32_t iteration = 0; iteration < options.iterations; iteration++) {
+			decode.measure([&]() {
+				decoded = TextureManager::decode(fs, uri, false);
+			});
+
+			if (decoded.mips.size() == 0) {
+				throw std::runtime_error("Unable to decode texture.");
+			}
+
+			if (decoded.compressed) {
+				decode_compressed.measure([&]() {
+					TextureManager::decode(fs, uri, true);
+				});
+			}
+		}
+
+		QJsonObject result;
+		result["texture"] = uri.toString();
+		result["width"] = (qint64)decoded.width;
+		result["height"] = (qint64)decoded.height;
+		result["mips"] = (qint64)decoded.mips.size();
+		result["decode"] = decode.toJson();
+		result["decode_compressed"] = decode_compressed.toJson();
+		return result;
+	}
+
+	// the csv is read into memory first, so only the parse and index build are measured.
+	QJsonObject benchmarkListFileParse(const QString& csv_path, const Options& options, bool& identical) {
+		QFile csv(csv_path);
+		if (!csv.open(QIODevice::ReadOnly)) {
+			throw std::runtime_error("Unable to open listfile " + csv_path.toStdString());
+		}
+
+		const QByteArray content = csv.readAll();
+		const std::span<const uint8_t> data(reinterpret_cast<const uint8_t*>(content.constData()), content.size());
+
+		Samples serial, parallel;
+		std::vector<uint8_t> serial_image, parallel_image;
+
+		for (uint32_t iteration = 0; iteration < options.iterations; iteration++) {
+			serial.measure([&]() {
+				serial_image = ListFileIndex::compile(data, 0, 0, false);
+			});
+
+			parallel.measure([&]() {
+				parallel_image = ListFileIndex::compile(data, 0, 0, true);
+			});
+		}
+
+		identical = serial_image == parallel_image;
+
+		const auto serial_json = serial.toJson();
+		const auto parallel_json = parallel.toJson();
+
+		QJsonObject result;
+		result["listfile"] = csv_path;
+		result["bytes"] = (qint64)content.size();
+		result["serial"] = serial_json;
+		result["parallel"] = parallel_json;
+		result["speedup_p50"] = serial_json["p50_us"].toDouble() / std::max(1.0, parallel_json["p50_us"].toDouble());
+		result["identical"] = identical;
+		return result;
+	}
+
+	// returns false if the output file cannot be written.
+	bool writeReport(const QJsonObject& report, const QString& output) {
+		const auto json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+		if (!output.isEmpty()) {
+			QFile out(output);
+			if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+				std::cerr << "Unable to write output file." << std::endl;
+				return false;
+			}
+			out.write(json);
+		}
+		else {
+			std::cout << json.toStdString();
+		}
+
+		return true;
+	}
+
+	std::unique_ptr<GameFileSystem> openGameDirectory(const QString& directory) {
+		const auto found = WDBReader::Detector::all().detect(directory.toStdString());
+		if (found.size() == 0) {
+			throw std::runtime_error("Unable to detect a game client in " + directory.toStdString());
+		}
+
+		const auto& detected = found.front();
+
+		GameClientInfo::Environment env;
+		env.directory = directory;
+		env.product = QString::fromStdString(detected.name);
+		env.locale = detected.locales.size() > 0 ? QString::fromStdString(detected.locales[0]) : "enUS";
+		env.version = detected.version;
+
+		const std::array<const GameClientInfo::Profile*, 8> profiles = {
+			&VanillaGameClientAdaptor::PROFILE,
+			&TBCGameClientAdaptor::PROFILE,
+			&WOTLKGameClientAdaptor::PROFILE,
+			&CataGameClientAdaptor::PROFILE,
+			&BFAGameClientAdaptor::PROFILE,
+			&SLGameClientAdaptor::PROFILE,
+			&DFGameClientAdaptor::PROFILE,
+			&TWWGameClientAdaptor::PROFILE
+		};
+
+		// same choice as the client dialog, an exact match otherwise the newest compatible profile.
+		const GameClientInfo::Profile* profile = nullptr;
+		for (const auto* candidate : profiles) {
+			if (candidate->targetVersion == env.version && candidate->storageFormat == detected.storageFormat) {
+				profile = candidate;
+				break;
+			}
+		}
+
+		if (profile == nullptr) {
+			for (auto it = profiles.crbegin(); it != profiles.crend(); ++it) {
+				if ((*it)->storageFormat == detected.storageFormat && env.version.expansion >= (*it)->targetVersion.expansion) {
+					profile = *it;
+					break;
+				}
+			}
+		}
+
+		if (profile == nullptr) {
+			throw std::runtime_error("Detected client version is not supported.");
+		}
+
+		auto adaptor = makeGameClientAdaptor(GameClientInfo(env, *profile));
+		if (adaptor == nullptr) {
+			throw std::runtime_error("Detected client version is not supported.");
+		}
+
+		return adaptor->filesystem(env);
+	}
+
+	QJsonObject toJson(const DiskFileCache::Stats& stats) {
+		QJsonObject result;
+		result["hits"] = (qint64)stats.hits;
+		result["misses"] = (qint64)stats.misses;
+		result["entries"] = (qint64)stats.entries;
+		result["bytes"] = (qint64)stats.bytes;
+		return result;
+	}
+
+	/*
+	* Opens the files through two separate filesystem instances, set up the same way as the app (disk cache beneath the in-memory cache.)
+	* The disk cache is rescanned from the directory by the second instance, as it would be on the next start,
+	* so every file read by the first session must then be a disk cache hit with the same content.
+	*/
+	QJsonObject checkDiskCache(const QString& game_directory, const QString& cache_directory, const std::vector<GameFileUri>& uris, bool& passed) {
+		constexpr uint64_t DISK_CACHE_BYTES = 1024ull * 1024 * 1024;
+		constexpr size_t FILE_CACHE_BYTES = 256 * 1024 * 1024;
+
+		std::map<QString, QByteArray> first_hashes;
+		QJsonArray sessions;
+		passed = true;
+
+		for (auto session = 0; session < 2; session++) {
+			auto source_fs = openGameDirectory(game_directory);
+			auto* casc_fs = dynamic_cast<CascFileSystem*>(source_fs.get());
+			if (casc_fs == nullptr) {
+				throw std::runtime_error("The disk cache is only used by CASC clients.");
+			}
+
+			casc_fs->enableDiskCache(cache_directory, DISK_CACHE_BYTES);
+			if (!casc_fs->diskCacheStats().has_value()) {
+				throw std::runtime_error("Unable to enable the disk cache.");
+			}
+
+			CachedFileSystem fs(std::move(source_fs), FILE_CACHE_BYTES);
+			auto loaded = fs.load();
+			if (loaded.valid()) {
+				loaded.get();
+			}
+
+			const auto before = casc_fs->diskCacheStats().value();
+			size_t opened = 0, mismatched = 0;
+
+			for (const auto& uri : uris) {
+				auto file = fs.openFile(uri);
+				if (file == nullptr) {
+					continue;
+				}
+
+				const auto content = file->data();
+				const auto hash = QCryptographicHash::hash(QByteArrayView(content.data(), content.size()), QCryptographicHash::Sha1);
+				opened++;
+
+				if (session == 0) {
+					first_hashes[uri.toString()] = hash;
+				}
+				else if (first_hashes[uri.toString()] != hash) {
+					mismatched++;
+				}
+			}
+
+			const auto after = casc_fs->diskCacheStats().value();
+			const auto hits = after.hits - before.hits;
+
+			if (session == 1 && (hits != opened || mismatched > 0)) {
+				passed = false;
+			}
+
+			QJsonObject result = toJson(after);
+			result["opened"] = (qint64)opened;
+			result["session_hits"] = (qint64)hits;
+			result["mismatched"] = (qint64)mismatched;
+			sessions.push_back(result);
+		}
+
+		QJsonObject result;
+		result["directory"] = cache_directory;
+		result["sessions"] = sessions;
+		result["passed"] = passed;
+		return result;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("WMVxBench");
+	core::Log::boot(&app);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Headless model load and animation benchmark.");
+	parser.addHelpOption();
+	parser.addOptions({
+		{ "game", "Game client directory.", "directory" },
+		{ "files", "Directory of extracted game files.", "directory" },
+		{ "listfile", "Listfile csv used to resolve file ids, with --files.", "csv" },
+		{ "models", "File listing the models to load, one per line.", "file" },
+		{ "decode", "Benchmark texture block decoding instead of models." },
+		{ "keyframes", "Benchmark keyframe search on generated tracks instead of models." },
+		{ "bones", "Benchmark bone evaluation on generated skeletons instead of models." },
+		{ "skinning", "Benchmark vertex skinning kernels on generated meshes instead of models." },
+		{ "parse-listfile", "Benchmark building the --listfile index serially and in parallel, instead of models." },
+		{ "disk-cache", "Check the casc disk cache is used across sessions, with --game.", "directory" },
+		{ "stress", "Open and read the files concurrently, checking every read against a single threaded read." },
+		{ "threads", "Number of threads used by --stress.", "count", QString::number(std::max(2, QThread::idealThreadCount() * 2)) },
+		{ "iterations", "Number of times each model is loaded, or each file is read with --stress.", "count", "10" },
+		{ "frames", "Number of frames animated per load.", "count", "300" },
+		{ "output", "Write results to a file instead of stdout.", "file" }
+	});
+	parser.addPositionalArgument("models", "Model paths or file ids.", "[models...]");
+	parser.process(app);
+
+	bench::Options options;
+	options.iterations = std::max(1u, parser.value("iterations").toUInt());
+	options.frames = parser.value("frames").toUInt();
+
+	if (parser.isSet("decode")) {
+		bool matches_reference = false;
+		QJsonObject report;
+		report["version"] = WMVX_VERSION;
+		report["decoding"] = bench::benchmarkBlockDecoding(options.iterations, matches_reference);
+
+		if (!bench::writeReport(report, parser.value("output"))) {
+			return 2;
+		}
+
+		return matches_reference ? 0 : 1;
+	}
+
+	if (parser.isSet("bones")) {
+		bool matches_recursive = false;
+		QJsonObject report;
+		report["version"] = WMVX_VERSION;
+		report["bone_evaluation"] = bench::benchmarkBoneEvaluation(options.iterations, matches_recursive);
+
+		if (!bench::writeReport(report, parser.value("output"))) {
+			return 2;
+		}
+
+		return matches_recursive ? 0 : 1;
+	}
+
+	if (parser.isSet("skinning")) {
+		bool matches_reference = false;
+		QJsonObject report;
+		report["version"] = WMVX_VERSION;
+		report["skinning"] = bench::benchmarkSkinning(options.iterations, matches_reference);
+
+		if (!bench::writeReport(report, parser.value("output"))) {
+			return 2;
+		}
+
+		return matches_reference ? 0 : 1;
+	}
+
+	if (parser.isSet("keyframes")) {
+		bool matches_linear = false;
+		QJsonObject report;
+		report["version"] = WMVX_VERSION;
+		report["keyframe_search"] = bench::benchmarkKeyframeSearch(options.iterations, matches_linear);
+
+		if (!bench::writeReport(report, parser.value("output"))) {
+			return 2;
+		}
+
+		return matches_linear ? 0 : 1;
+	}
+
+	if (parser.isSet("parse-listfile")) {
+		if (!parser.isSet("listfile")) {
+			parser.showHelp(2);
+		}
+
+		bool identical = false;
+		QJsonObject report;
+		report["version"] = WMVX_VERSION;
+
+		try {
+			report["listfile_parse"] = bench::benchmarkListFileParse(parser.value("listfile"), options, identical);
+		}
+		catch (const std::exception& e) {
+			std::cerr << e.what() << std::endl;
+			return 2;
+		}
+
+		if (!bench::writeReport(report, parser.value("output"))) {
+			return 2;
+		}
+
+		return identical ? 0 : 1;
+	}
+
+	QStringList model_names = parser.positionalArguments();
+	if (parser.isSet("models")) {
+		QFile list(parser.value("models"));
+		if (!list.open(QIODevice::ReadOnly | QIODevice::Text)) {
+			std::cerr << "Unable to open model list." << std::endl;
+			return 2;
+		}
+
+		QTextStream stream(&list);
+		while (!stream.atEnd()) {
+			const auto line = stream.readLine().trimmed();
+			if (!line.isEmpty() && !line.startsWith('#')) {
+				model_names.push_back(line);
+			}
+		}
+	}
+
+	if (model_names.isEmpty() || parser.isSet("game") == parser.isSet("files")) {
+		parser.showHelp(2);
+	}
+
+	const auto to_uri = [](const QString& name) {
+		bool is_id = false;
+		const auto id = name.toUInt(&is_id);
+		return is_id ? core::GameFileUri(id) : core::GameFileUri(name);
+	};
+
+	if (parser.isSet("disk-cache")) {
+		if (!parser.isSet("game")) {
+			parser.showHelp(2);
+		}
+
+		std::vector<core::GameFileUri> uris;
+		for (const auto& name : model_names) {
+			uris.push_back(to_uri(name));
+		}
+
+		bool passed = false;
+		QJsonObject report;
+		report["version"] = WMVX_VERSION;
+
+		try {
+			report["disk_cache"] = bench::checkDiskCache(parser.value("game"), parser.value("disk-cache"), uris, passed);
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Unable to check disk cache: " << e.what() << std::endl;
+			return 2;
+		}
+
+		if (!bench::writeReport(report, parser.value("output"))) {
+			return 2;
+		}
+
+		return passed ? 0 : 1;
+	}
+
+	const auto open_fs = [&]() -> std::unique_ptr<core::GameFileSystem> {
+		std::unique_ptr<core::GameFileSystem> result;
+		if (parser.isSet("game")) {
+			// file content is not cached, so every iteration reads from the client storage.
+			result = bench::openGameDirectory(parser.value("game"));
+		}
+		else {
+			result = std::make_unique<bench::LocalFileSystem>(parser.value("files"), parser.value("listfile"));
+		}
+
+		return result;
+	};
+
+	const auto load_fs = [](core::GameFileSystem* target) {
+		auto loaded = target->load();
+		if (loaded.valid()) {
+			loaded.get();
+		}
+	};
+
+	if (parser.isSet("stress")) {
+		std::vector<core::GameFileUri> uris;
+		for (const auto& name : model_names) {
+			uris.push_back(to_uri(name));
+		}
+
+		const auto threads = std::max(1u, parser.value("threads").toUInt());
+		bool passed = true;
+		QJsonObject backends;
+
+		try {
+			// the backend on its own, then behind the in-memory cache as the app uses it.
+			auto source_fs = open_fs();
+			load_fs(source_fs.get());
+
+			auto cached_fs = std::make_unique<core::CachedFileSystem>(open_fs(), 256 * 1024 * 1024);
+			load_fs(cached_fs.get());
+
+			for (const auto& [name, target] : { std::pair{ "source", source_fs.get() }, std::pair{ "cached", (core::GameFileSystem*)cached_fs.get() } }) {
+				bool backend_passed = false;
+				backends[name] = bench::stressFileSystem(target, uris, threads, options.iterations, backend_passed);
+				passed = passed && backend_passed;
+			}
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Unable to open file system: " << e.what() << std::endl;
+			return 2;
+		}
+
+		QJsonObject report;
+		report["version"] = WMVX_VERSION;
+		report["stress"] = backends;
+
+		if (!bench::writeReport(report, parser.value("output"))) {
+			return 2;
+		}
+
+		return passed ? 0 : 1;
+	}
+
+	std::unique_ptr<core::GameFileSystem> fs;
+
+	try {
+		fs = open_fs();
+		load_fs(fs.get());
+	}
+	catch (const std::exception& e) {
+		std::cerr << "Unable to open file system: " << e.what() << std::endl;
+		return 2;
+	}
+
+	QJsonArray results;
+	bool failed = false;
+
+	for (const auto& name : model_names) {
+		const core::GameFileUri uri = to_uri(name);
+
+		try {
+			if (name.endsWith(".blp", Qt::CaseInsensitive)) {
+				results.push_back(bench::benchmarkTexture(fs.get(), uri, options));
+			}
+			else {
+				results.push_back(bench::benchmarkModel(fs.get(), uri, options));
+			}
+		}
+		catch (const std::exception& e) {
+			QJsonObject error;
+			error["model"] = name;
+			error["error"] = QString::fromStdString(e.what());
+			results.push_back(error);
+			failed = true;
+		}
+	}
+
+	QString kernel;
+	switch (core::VertexSkinning::kernel()) {
+	case core::VertexSkinning::Kernel::AVX2:
+		kernel = "avx2";
+		break;
+	case core::VertexSkinning::Kernel::SSE2:
+		kernel = "sse2";
+		break;
+	default:
+		kernel = "scalar";
+		break;
+	}
+
+	QJsonObject report;
+	report["version"] = WMVX_VERSION;
+	report["skinning_kernel"] = kernel;
+	report["iterations"] = (qint64)options.iterations;
+	report["frames"] = (qint64)options.frames;
+	report["frame_delta_ms"] = (qint64)options.frameDelta;
+	report["models"] = results;
+
+	if (!bench::writeReport(report, parser.value("output"))) {
+		return 2;
+	}
+
+	return failed ? 1 : 0;
+}
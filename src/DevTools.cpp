@@ -42,6 +42,7 @@ DevTools::DevTools(QWidget *parent)
 	
 	connect(observeTimer, &QTimer::timeout, [&]() {
 		updateAttachments();
+		updateTextureStats();
 	});
 
 	ui.treeWidgetGeosets->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
@@ -172,6 +173,7 @@ void DevTools::updateAttachments()
 
 void DevTools::updateTextures() {
 	ui.listWidgetTextures->clear();
+	updateTextureStats();
 
 	if (model == nullptr) {
 		return;
@@ -198,6 +200,21 @@ void DevTools::updateTextures() {
 	ui.listWidgetTextures->setDisabled(false);
 }
 
+void DevTools::updateTextureStats() {
+	if (scene == nullptr) {
+		ui.labelTextureStats->clear();
+		return;
+	}
+
+	const auto stats = scene->textureManager.stats();
+	const auto requests = stats.hits + stats.misses;
+
+	ui.labelTextureStats->setText(QString("Cached: %1 | Hits: %2 | Misses: %3 | Shared: %4%")
+		.arg(stats.entries)
+		.arg(stats.hits)
+		.arg(stats.misses)
+		.arg(requests > 0 ? (100.0 * stats.hits) / requests : 0.0, 0, 'f', 1));
+}
 
 QTreeWidgetItem* DevTools::createGeosetTreeNode(const core::ModelGeosetInfo* geoset_info, const core::M2Model* raw, QString name) {
 	auto items = std::map<uint16_t, std::vector<uint32_t>>();
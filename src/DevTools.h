@@ -27,6 +27,7 @@ private:
 	void updateGeosets();
 	void updateAttachments();
 	void updateTextures();
+	void updateTextureStats();
 
 	QTreeWidgetItem* createGeosetTreeNode(const core::ModelGeosetInfo* geoset_info, const core::M2Model* raw, QString name);
 	QTreeWidgetItem* createGeosetAttachmentTreeNode(const core::ModelGeosetInfo* geoset_info, const core::M2Model* raw, QString name, int relation_index);
@@ -65,6 +65,9 @@ Export3dDialog::Export3dDialog(core::GameDatabase* db, core::Scene* _scene, QWid
 		}
 
 		try {
+			// textures are read back from GL, so any still decoding must be uploaded first.
+			scene->textureManager.finishUploads();
+
 			exporter::FbxExporter exporter(outFile);
 			auto* target = getTargetModel();
 			if (target != nullptr) {
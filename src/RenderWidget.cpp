@@ -66,6 +66,12 @@ void RenderWidget::initializeGL()
 		core::Log::message(VideoCapabilities::hardware().vendor);
 		core::Log::message(VideoCapabilities::hardware().version);
 		core::Log::message(VideoCapabilities::hardware().renderer);
+
+		// the scene is assigned before the widget is first shown.
+		if (scene != nullptr) {
+			scene->textureManager.setCompressedUpload(VideoCapabilities::support().compression);
+			core::Log::message(QString("Compressed texture upload: %1").arg(VideoCapabilities::support().compression ? "enabled" : "disabled"));
+		}
 	}
 
 	//TODO log ogl support
@@ -80,9 +86,7 @@ void RenderWidget::initializeGL()
 	connect(timer, &QTimer::timeout, this, [&, updateTick]() {
 		update();
 		if (scene != nullptr) {
-			for (auto& model : scene->models) {
-				model->update(updateTick);
-			}
+			scene->update(updateTick);
 		}
 	});
 	timer->setInterval(updateTick);
@@ -100,6 +104,9 @@ void RenderWidget::paintGL()
 	camera->setup();
 	if (scene != nullptr) {
 
+		// textures decoded since the last frame, limited so a large model doesnt stall rendering while its textures arrive.
+		scene->textureManager.processUploads(std::chrono::milliseconds(4));
+
 		if (scene->showGrid) {
 			renderGrid();
 		}
@@ -137,9 +144,9 @@ void RenderWidget::paintGL()
 						glBegin(GL_TRIANGLES);
 						for (size_t k = 0, b = pass.indexStart; k < pass.indexCount; k++, b++) {
 							uint16_t a = model->model->getIndices()[b];
-							glNormal3fv((GLfloat*)&model->animatedNormals[a]);
+							glNormal3fv((GLfloat*)&model->getAnimatedNormals()[a]);
 							glTexCoord2fv((GLfloat*)&model->model->getRawVertices()[a].textureCoords);
-							glVertex3fv((GLfloat*)&model->animatedVertices[a]);
+							glVertex3fv((GLfloat*)&model->getAnimatedVertices()[a]);
 						}
 						glEnd();
 
@@ -193,9 +200,9 @@ void RenderWidget::paintGL()
 									glBegin(GL_TRIANGLES);
 									for (size_t k = 0, b = pass.indexStart; k < pass.indexCount; k++, b++) {
 										uint16_t a = owned->model->getIndices()[b];
-										glNormal3fv((GLfloat*)&owned->animatedNormals[a]);
+										glNormal3fv((GLfloat*)&owned->getAnimatedNormals()[a]);
 										glTexCoord2fv((GLfloat*)&owned->model->getRawVertices()[a].textureCoords);
-										glVertex3fv((GLfloat*)&owned->animatedVertices[a]);
+										glVertex3fv((GLfloat*)&owned->getAnimatedVertices()[a]);
 									}
 									glEnd();
 
@@ -230,9 +237,9 @@ void RenderWidget::paintGL()
 											glBegin(GL_TRIANGLES);
 											for (size_t k = 0, b = pass.indexStart; k < pass.indexCount; k++, b++) {
 												uint16_t a = effect->model->getIndices()[b];
-												glNormal3fv((GLfloat*)&effect->animatedNormals[a]);
+												glNormal3fv((GLfloat*)&effect->getAnimatedNormals()[a]);
 												glTexCoord2fv((GLfloat*)&effect->model->getRawVertices()[a].textureCoords);
-												glVertex3fv((GLfloat*)&effect->animatedVertices[a]);
+												glVertex3fv((GLfloat*)&effect->getAnimatedVertices()[a]);
 											}
 											glEnd();
 
@@ -276,9 +283,9 @@ void RenderWidget::paintGL()
 								glBegin(GL_TRIANGLES);
 								for (size_t k = 0, b = pass.indexStart; k < pass.indexCount; k++, b++) {
 									uint16_t a = rel->model->getIndices()[b];
-									glNormal3fv((GLfloat*)&rel->animatedNormals[a]);
+									glNormal3fv((GLfloat*)&rel->getAnimatedNormals()[a]);
 									glTexCoord2fv((GLfloat*)&rel->model->getRawVertices()[a].textureCoords);
-									glVertex3fv((GLfloat*)&rel->animatedVertices[a]);
+									glVertex3fv((GLfloat*)&rel->getAnimatedVertices()[a]);
 								}
 								glEnd();
 
@@ -10,7 +10,10 @@
 #include "WMVxVideoCapabilities.h"
 #include "ExportImageDialog.h"
 #include "Export3dDialog.h"
+#include "core/modeling/M2.h"
 #include "core/modeling/SceneIO.h"
+#include "core/filesystem/CachedFileSystem.h"
+#include "core/filesystem/CascFileSystem.h"
 #include <QProgressDialog>
 #include <QtConcurrent>
 
@@ -130,6 +133,9 @@ WMVx::WMVx(QWidget* parent)
 
 WMVx::~WMVx()
 {
+    // the scene outlives gameFS, texture decodes and animation reads still running must finish before the filesystem is released.
+    scene->textureManager.cancelPending();
+    M2DataCache::global().release(gameFS.get());
     Log::message("WMVx destroyed.");
 }
 
@@ -214,6 +220,10 @@ void WMVx::onGameClientChosen(core::GameClientInfo clientInfo) {
 
     isLoadingClient = true;
 
+    // the filesystem is replaced while loading, textures and animations from the previous client must not still be reading from it.
+    scene->textureManager.cancelPending();
+    M2DataCache::global().release(gameFS.get());
+
     QtConcurrent::run([&, gameAdaptor]() {
 
         try {
@@ -221,7 +231,16 @@ void WMVx::onGameClientChosen(core::GameClientInfo clientInfo) {
                 clientProgressDialog->setLabelText("Loading filesystem...");
             });
 
-            gameFS = gameAdaptor->filesystem(gameClientInfo->environment);
+            // cache sizes are configured in megabytes.
+            const auto file_cache_bytes = static_cast<size_t>(std::max(Settings::get<int32_t>(config::client::file_cache_size), 0)) * 1024 * 1024;
+            const auto disk_cache_bytes = static_cast<uint64_t>(std::max(Settings::get<int32_t>(config::client::disk_cache_size), 0)) * 1024 * 1024;
+
+            auto source_fs = gameAdaptor->filesystem(gameClientInfo->environment);
+            if (auto* casc_fs = dynamic_cast<CascFileSystem*>(source_fs.get()); casc_fs != nullptr) {
+                casc_fs->enableDiskCache("Cache", disk_cache_bytes);
+            }
+
+            gameFS = std::make_unique<CachedFileSystem>(std::move(source_fs), file_cache_bytes);
             auto fs_future = gameFS->load();
 
             QMetaObject::invokeMethod(this, [&] {
@@ -406,6 +425,8 @@ void WMVx::unloadGameClient()
 
     emit gameConfigLoaded(nullptr, nullptr, modelSupport);
 
+    scene->textureManager.cancelPending();
+    M2DataCache::global().release(gameFS.get());
     gameFS.reset();
     gameDB.reset();
 }
@@ -27,6 +27,8 @@ void WMVxSettings::load()
 	load_key(config::app::support_auto_update, false);
 
 	load_key(config::client::game_folder, "");
+	load_key(config::client::file_cache_size, int32_t(256));
+	load_key(config::client::disk_cache_size, int32_t(0));
 
 	load_key(config::exporter::last_image_directory, "");
 	load_key(config::exporter::last_3d_directory, "");
@@ -13,6 +13,8 @@ WMVX_CONFIG_KEY(app, auto_animate_new_models)
 WMVX_CONFIG_KEY(app, support_auto_update)
 
 WMVX_CONFIG_KEY(client, game_folder)
+WMVX_CONFIG_KEY(client, file_cache_size)
+WMVX_CONFIG_KEY(client, disk_cache_size)
 
 WMVX_CONFIG_KEY(exporter, last_image_directory)
 WMVX_CONFIG_KEY(exporter, last_3d_directory)
@@ -20,7 +20,7 @@ namespace core {
 	class BFACharSectionsDataset : public DatasetCharacterSections {
 	public:
 		using Adaptor = BFACharSectionsRecordAdaptor;
-		BFACharSectionsDataset(CascFileSystem* fs, const IFileDataGameDatabase* fdDB) :
+		BFACharSectionsDataset(GameFileSystem* fs, const IFileDataGameDatabase* fdDB) :
 			DatasetCharacterSections(),
 			fileDataDB(fdDB)
 		{
@@ -15,39 +15,39 @@ namespace core {
 
 		void load(const GameFileSystem* const fs) override {
 
-				auto* const cascFS = (CascFileSystem*)(fs);
+				auto* const gameFS = const_cast<GameFileSystem*>(fs);
 
-				loadFileData(cascFS);
+				loadFileData(gameFS);
 
 				auto items_async = std::async(std::launch::async, [&]() {
-					itemsDB = std::make_unique<BFAItemDataset>(cascFS);
+					itemsDB = std::make_unique<BFAItemDataset>(gameFS);
 				});
 
 				auto items_display_async = std::async(std::launch::async, [&]() {
-					itemDisplayDB = std::make_unique<BFAItemDisplayInfoDataset>(cascFS, this);
+					itemDisplayDB = std::make_unique<BFAItemDisplayInfoDataset>(gameFS, this);
 				});
 
-				animationDataDB = std::make_unique<BFAAnimationDataDataset>(cascFS, "dbfilesclient/animationdata.db2", "Support Files\\animation-names.csv");
+				animationDataDB = std::make_unique<BFAAnimationDataDataset>(gameFS, "dbfilesclient/animationdata.db2", "Support Files\\animation-names.csv");
 
 				auto creatures_async = std::async(std::launch::async, [&]() {
-					creatureModelDataDB = std::make_unique<BFACreatureModelDataDataset>(cascFS, "dbfilesclient/creaturemodeldata.db2");
-					creatureDisplayDB = std::make_unique<BFACreatureDisplayDataset>(cascFS);
+					creatureModelDataDB = std::make_unique<BFACreatureModelDataDataset>(gameFS, "dbfilesclient/creaturemodeldata.db2");
+					creatureDisplayDB = std::make_unique<BFACreatureDisplayDataset>(gameFS);
 				});
 
-				characterRacesDB = std::make_unique< BFACharRacesDataset>(cascFS, "dbfilesclient/chrraces.db2");
-				characterSectionsDB = std::make_unique<BFACharSectionsDataset>(cascFS, this);
+				characterRacesDB = std::make_unique< BFACharRacesDataset>(gameFS, "dbfilesclient/chrraces.db2");
+				characterSectionsDB = std::make_unique<BFACharSectionsDataset>(gameFS, this);
 
-				characterFacialHairStylesDB = std::make_unique<BFACharacterFacialHairStylesDataset>(cascFS, "dbfilesclient/characterfacialhairstyles.db2");
-				characterHairGeosetsDB = std::make_unique<BFACharHairGeosetsDataset>(cascFS, "dbfilesclient/charhairgeosets.db2");
+				characterFacialHairStylesDB = std::make_unique<BFACharacterFacialHairStylesDataset>(gameFS, "dbfilesclient/characterfacialhairstyles.db2");
+				characterHairGeosetsDB = std::make_unique<BFACharHairGeosetsDataset>(gameFS, "dbfilesclient/charhairgeosets.db2");
 
-				characterComponentTexturesDB = std::make_unique<BFACharacterComponentTextureDataset>(cascFS);
+				characterComponentTexturesDB = std::make_unique<BFACharacterComponentTextureDataset>(gameFS);
 
 				//TODO
 				itemVisualsDB = nullptr;
 				itemVisualEffectsDB = nullptr;
 				spellEnchantmentsDB = nullptr;
 
-				npcsDB = std::make_unique<BFANPCsDataset>(cascFS, "dbfilesclient/creature.db2");
+				npcsDB = std::make_unique<BFANPCsDataset>(gameFS, "dbfilesclient/creature.db2");
 
 				creatures_async.wait();
 				items_async.wait();
@@ -4,14 +4,12 @@
 #include <array>
 #include <span>
 #include "../filesystem/GameFileUri.h"
-#include "../filesystem/CascFileSystem.h"
+#include "../filesystem/GameFileSystem.h"
 #include "../database/GameDatasetAdaptors.h"
 #include <WDBReader/Database/DB2File.hpp>
 
 namespace core {
 
-	class CascFileSystem;
-
 	class IFileDataGameDatabase {
 	public:
 		IFileDataGameDatabase() = default;
@@ -53,7 +51,7 @@ namespace core {
 		FileDataGameDatabase(FileDataGameDatabase&&) = default;
 		virtual ~FileDataGameDatabase() = default;
 
-		inline void loadFileData(CascFileSystem* const fs) 
+		inline void loadFileData(GameFileSystem* const fs) 
 		{
 			auto open_casc_source = [&fs](const auto& name) -> std::unique_ptr<WDBR::Filesystem::FileSource> {
 				auto file = fs->openFile(name);
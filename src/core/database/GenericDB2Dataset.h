@@ -1,6 +1,6 @@
 #pragma once
 
-#include "../filesystem/CascFileSystem.h"
+#include "../filesystem/GameFileSystem.h"
 #include <vector>
 #include <WDBReader/Database.hpp>
 
@@ -10,7 +10,7 @@ namespace core {
 	class GenericDB2Dataset : public BaseDataset {
 	public:
 		using Adaptor = ImplAdaptor;
-		GenericDB2Dataset(CascFileSystem* fs, const GameFileUri& uri) : BaseDataset()
+		GenericDB2Dataset(GameFileSystem* fs, const GameFileUri& uri) : BaseDataset()
 		{
 			auto file = fs->openFile(uri);
 			if (file == nullptr) {
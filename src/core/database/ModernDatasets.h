@@ -3,7 +3,7 @@
 #include "GameDataset.h"
 #include "ModernDatasetAdaptors.h"
 #include "GenericDB2Dataset.h"
-#include "../filesystem/CascFileSystem.h"
+#include "../filesystem/GameFileSystem.h"
 
 namespace core {
 
@@ -13,7 +13,7 @@ namespace core {
 	public:
 		using Adaptor = ImplAdaptor;
 
-		ModernAnimationDataDataset(CascFileSystem* fs, const GameFileUri& uri, const QString& animationReferenceFileName) :
+		ModernAnimationDataDataset(GameFileSystem* fs, const GameFileUri& uri, const QString& animationReferenceFileName) :
 			DatasetAnimationData(), ReferenceSourceAnimationNames(animationReferenceFileName)
 		{
 			auto file = fs->openFile(uri);
@@ -50,7 +50,7 @@ namespace core {
 		class ModernCharacterComponentTextureDataset : public DatasetCharacterComponentTextures {
 		public:
 			using Adaptor = T_Adaptor;
-			ModernCharacterComponentTextureDataset(CascFileSystem* fs) : DatasetCharacterComponentTextures() {
+			ModernCharacterComponentTextureDataset(GameFileSystem* fs) : DatasetCharacterComponentTextures() {
 				
 				{
 					auto sections_file = fs->openFile("dbfilesclient/charcomponenttexturesections.db2");
@@ -115,7 +115,7 @@ namespace core {
 	class ModernCreatureDisplayDataset : public DatasetCreatureDisplay {
 	public:
 		using Adaptor = T_Adaptor;
-		ModernCreatureDisplayDataset(CascFileSystem* fs) : DatasetCreatureDisplay()
+		ModernCreatureDisplayDataset(GameFileSystem* fs) : DatasetCreatureDisplay()
 		{
 			std::unordered_map<uint32_t, std::unique_ptr<CreatureDisplayExtraRecordAdaptor>> extras;
 			if constexpr (!std::is_same_v<T_ExtraAdaptor, void>)
@@ -180,7 +180,7 @@ namespace core {
 	class ModernItemDataset : public DatasetItems {
 	public:
 		using Adaptor = T_ItemRecordAdaptor;
-		ModernItemDataset(CascFileSystem* fs) : DatasetItems()
+		ModernItemDataset(GameFileSystem* fs) : DatasetItems()
 		{
 
 			std::unordered_map<uint32_t, const T_ItemSparseRecord*> sparse_map;
@@ -303,7 +303,7 @@ namespace core {
 	class ModernItemDisplayInfoDataset : public DatasetItemDisplay {
 	public:
 		using Adaptor = T_Adaptor;
-		ModernItemDisplayInfoDataset(CascFileSystem* fs, const IFileDataGameDatabase* fdDB) : DatasetItemDisplay()
+		ModernItemDisplayInfoDataset(GameFileSystem* fs, const IFileDataGameDatabase* fdDB) : DatasetItemDisplay()
 		{
 
 			std::unordered_multimap<uint32_t, const T_MatResRecord*> materials_map;
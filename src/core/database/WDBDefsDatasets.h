@@ -69,7 +69,7 @@ namespace core {
 	public:
 		using Adaptor = ImplAdaptor;
 
-		ModernWDBDefsAnimationDataDataset(CascFileSystem* fs, const WDBReader::GameVersion& version, const QString& animationReferenceFileName) :
+		ModernWDBDefsAnimationDataDataset(GameFileSystem* fs, const WDBReader::GameVersion& version, const QString& animationReferenceFileName) :
 			DatasetAnimationData(), ReferenceSourceAnimationNames(animationReferenceFileName)
 		{
 			auto file = fs->openFile("dbfilesclient/animationdata.db2");
@@ -113,7 +113,7 @@ namespace core {
 	class ModernWDBDefsCharacterComponentTextureDataset : public DatasetCharacterComponentTextures {
 	public:
 		using Adaptor = ImplAdaptor;
-		ModernWDBDefsCharacterComponentTextureDataset(CascFileSystem* fs, const WDBReader::GameVersion& version) : DatasetCharacterComponentTextures() {
+		ModernWDBDefsCharacterComponentTextureDataset(GameFileSystem* fs, const WDBReader::GameVersion& version) : DatasetCharacterComponentTextures() {
 
 			std::unordered_map<uint32_t, std::map<CharacterRegion, CharacterRegionCoords>> sections_map;
 
@@ -266,7 +266,7 @@ namespace core {
 	class ModernWDBDefsItemDataset : public DatasetItems {
 		public:
 			using Adaptor = ImplAdaptor;
-			ModernWDBDefsItemDataset(CascFileSystem* fs, const WDBReader::GameVersion& version) : DatasetItems()
+			ModernWDBDefsItemDataset(GameFileSystem* fs, const WDBReader::GameVersion& version) : DatasetItems()
 			{
 
 				auto sparse_schema = std::make_shared<WDBReader::Database::RuntimeSchema>(
@@ -405,7 +405,7 @@ namespace core {
 	class ModernWDBDefsItemDisplayInfoDataset : public DatasetItemDisplay {
 	public:
 		using Adaptor = ImplAdaptor;
-		ModernWDBDefsItemDisplayInfoDataset(CascFileSystem* fs, const WDBReader::GameVersion& version, const IFileDataGameDatabase* fdDB) : DatasetItemDisplay()
+		ModernWDBDefsItemDisplayInfoDataset(GameFileSystem* fs, const WDBReader::GameVersion& version, const IFileDataGameDatabase* fdDB) : DatasetItemDisplay()
 		{
 
 			auto schema = std::make_shared<WDBReader::Database::RuntimeSchema>(
@@ -15,7 +15,7 @@ namespace core {
 		WDBDefsFileDataGameDatabase(WDBDefsFileDataGameDatabase&&) = default;
 		virtual ~WDBDefsFileDataGameDatabase() = default;
 
-		inline void loadFileData(CascFileSystem* const fs)
+		inline void loadFileData(GameFileSystem* const fs)
 		{
 			auto open_casc_source = [&fs](const auto& name) -> std::unique_ptr<WDBR::Filesystem::FileSource> {
 				auto file = fs->openFile(name);
@@ -214,33 +214,33 @@ namespace core {
 
 		void load(const GameFileSystem* const fs) override {
 
-			auto* const cascFS = (CascFileSystem*)(fs);
+			auto* const gameFS = const_cast<GameFileSystem*>(fs);
 
-			loadFileData(cascFS);
+			loadFileData(gameFS);
 
 			auto items_async = std::async(std::launch::async, [&]() {
-				itemsDB = std::make_unique<ModernWDBDefsItemDataset<ModernWDBDefsItemRecordAdaptor>>(cascFS, version);
+				itemsDB = std::make_unique<ModernWDBDefsItemDataset<ModernWDBDefsItemRecordAdaptor>>(gameFS, version);
 			});
 
 			auto items_display_async = std::async(std::launch::async, [&]() {
-				itemDisplayDB = std::make_unique<ModernWDBDefsItemDisplayInfoDataset<ModernWDBDefsItemDisplayInfoRecordAdaptor>>(cascFS, version, this);
+				itemDisplayDB = std::make_unique<ModernWDBDefsItemDisplayInfoDataset<ModernWDBDefsItemDisplayInfoRecordAdaptor>>(gameFS, version, this);
 			});
 
-			animationDataDB = std::make_unique<ModernWDBDefsAnimationDataDataset<ModernWDBDefsAnimationDataRecordAdaptor>>(cascFS, version, "Support Files\\animation-names.csv");
+			animationDataDB = std::make_unique<ModernWDBDefsAnimationDataDataset<ModernWDBDefsAnimationDataRecordAdaptor>>(gameFS, version, "Support Files\\animation-names.csv");
 
 			auto creatures_async = std::async(std::launch::async, [&]() {
 				creatureModelDataDB = std::make_unique<GenericWDBDefsDataset<DatasetCreatureModelData,ModernWDBDefsCreatureModelDataRecordAdaptor>>(
-					cascFS, 
+					gameFS, 
 					"dbfilesclient/creaturemodeldata.db2",
 					version,
 					"CreatureModelData.dbd"
 				);
 
-				creatureDisplayDB = std::make_unique<ModernWDBDefsCreatureDisplayDataset<ModernWDBDefsCreatureDisplayRecordAdaptor>>(cascFS, version);
+				creatureDisplayDB = std::make_unique<ModernWDBDefsCreatureDisplayDataset<ModernWDBDefsCreatureDisplayRecordAdaptor>>(gameFS, version);
 			});
 
 			characterRacesDB = std::make_unique<GenericWDBDefsDataset<DatasetCharacterRaces, ModernWDBDefsCharRacesRecordAdaptor>>(
-				cascFS, 
+				gameFS, 
 				"dbfilesclient/chrraces.db2", 
 				version,  
 				"ChrRaces.dbd"
@@ -248,10 +248,10 @@ namespace core {
 			characterSectionsDB = nullptr;	//TODO make conditional.
 
 			//TODO / conditional.
-			//characterFacialHairStylesDB = std::make_unique<DFCharacterFacialHairStylesDataset>(cascFS, "dbfilesclient/characterfacialhairstyles.db2");
-			//characterHairGeosetsDB = std::make_unique<DFCharHairGeosetsDataset>(cascFS, "dbfilesclient/charhairgeosets.db2");
+			//characterFacialHairStylesDB = std::make_unique<DFCharacterFacialHairStylesDataset>(gameFS, "dbfilesclient/characterfacialhairstyles.db2");
+			//characterHairGeosetsDB = std::make_unique<DFCharHairGeosetsDataset>(gameFS, "dbfilesclient/charhairgeosets.db2");
 
-			characterComponentTexturesDB = std::make_unique<ModernWDBDefsCharacterComponentTextureDataset<ModernWDBDefsCharacterComponentTextureAdaptor>>(cascFS, version);
+			characterComponentTexturesDB = std::make_unique<ModernWDBDefsCharacterComponentTextureDataset<ModernWDBDefsCharacterComponentTextureAdaptor>>(gameFS, version);
 
 			//TODO
 			itemVisualsDB = nullptr;
@@ -259,7 +259,7 @@ namespace core {
 			spellEnchantmentsDB = nullptr;
 
 			npcsDB = std::make_unique<GenericWDBDefsDataset<DatasetNPCs, ModernWDBDefsNPCRecordAdaptor>>(
-				cascFS,
+				gameFS,
 				"dbfilesclient/creature.db2",
 				version,
 				"Creature.dbd"
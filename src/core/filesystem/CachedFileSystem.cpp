@@ -0,0 +1,167 @@
+#include "../../stdafx.h"
+#include "CachedFileSystem.h"
+#include "../utility/Exceptions.h"
+#include <atomic>
+#include <cstring>
+
+namespace core {
+
+	void BufferedArchiveFile::read(void* dest, uint64_t bytes, uint64_t offset)
+	{
+		if (offset + bytes > _buffer->size()) {
+			throw FileIOException(_uri.toString().toStdString(), "Attempted to read beyond end of file.");
+		}
+
+		memcpy(dest, _buffer->data() + offset, bytes);
+	}
+
+	std::unique_ptr<WDBReader::Filesystem::FileSource> BufferedArchiveFile::release()
+	{
+		auto file = _source->openFile(_uri);
+		if (file == nullptr) {
+			throw FileIOException(_uri.toString().toStdString(), "Unable to reopen file.");
+		}
+
+		return file->release();
+	}
+
+	CachedFileSystem::CachedFileSystem(std::unique_ptr<GameFileSystem> source, size_t byte_budget) :
+		GameFileSystem("", ""),
+		_source(std::move(source)),
+		_seperator(_source->seperator()),
+		byteBudget(byte_budget)
+	{}
+
+	std::unique_ptr<ArchiveFile> CachedFileSystem::openFile(const GameFileUri& uri)
+	{
+		auto key = makeKey(uri);
+		if (!key.has_value() || byteBudget == 0) {
+			return _source->openFile(uri);
+		}
+
+		{
+			std::scoped_lock lock(mutex);
+			auto it = entries.find(*key);
+			if (it != entries.end()) {
+				_stats.hits++;
+				recent.splice(recent.begin(), recent, it->second.position);
+				return std::make_unique<BufferedArchiveFile>(uri, it->second.buffer, _source.get());
+			}
+
+			_stats.misses++;
+		}
+
+		auto file = _source->openFile(uri);
+		if (file == nullptr) {
+			return nullptr;
+		}
+
+		const auto size = file->getFileSize();
+		if (size > maxEntryBytes()) {
+			return file;
+		}
+
+		// taken through data() rather than read(), so the source still sees the content (e.g casc writing its disk cache.)
+		auto buffer = std::make_shared<std::vector<uint8_t>>(file->takeData());
+
+		{
+			std::scoped_lock lock(mutex);
+			// another thread may have loaded the same file in the meantime, keep the existing entry.
+			if (!entries.contains(*key)) {
+				recent.push_front(*key);
+				entries.emplace(*key, Entry{ buffer, recent.begin() });
+				_stats.bytes += buffer->size();
+				_stats.entries = entries.size();
+				evict();
+			}
+		}
+
+		return std::make_unique<BufferedArchiveFile>(uri, std::move(buffer), _source.get());
+	}
+
+	std::future<void> CachedFileSystem::prefetch(std::span<const GameFileUri> uris)
+	{
+		if (uris.empty() || byteBudget == 0) {
+			return std::future<void>();
+		}
+
+		struct Progress {
+			std::promise<void> done;
+			std::atomic<size_t> remaining;
+		};
+
+		auto progress = std::make_shared<Progress>();
+		progress->remaining = uris.size();
+		auto result = progress->done.get_future();
+
+		// opening through the cache is enough to populate it, the files themselves can be dropped.
+		for (const auto& uri : uris) {
+			openPool->start([this, uri, progress]() {
+				try {
+					openFile(uri);
+				}
+				catch (const std::exception&) {
+					// prefetch is only a hint, the real open will report the error.
+				}
+
+				if (progress->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+					progress->done.set_value();
+				}
+			});
+		}
+
+		return result;
+	}
+
+	CachedFileSystem::Stats CachedFileSystem::stats() const
+	{
+		std::scoped_lock lock(mutex);
+		return _stats;
+	}
+
+	void CachedFileSystem::clear()
+	{
+		std::scoped_lock lock(mutex);
+		_stats.evictions += entries.size();
+		entries.clear();
+		recent.clear();
+		_stats.bytes = 0;
+		_stats.entries = 0;
+	}
+
+	std::optional<CachedFileSystem::key_t> CachedFileSystem::makeKey(const GameFileUri& uri) const
+	{
+		// the same file may be requested by id or by path (in any case), normalise to the filesystem's own format.
+		GameFileUri internal;
+		try {
+			internal = _source->asInternal(uri);
+		}
+		catch (const std::exception&) {
+			return std::nullopt;
+		}
+
+		if (internal.isEmpty()) {
+			return std::nullopt;
+		}
+
+		if (internal.isPath()) {
+			return key_t(internal.getPath().toLower());
+		}
+
+		return key_t(internal.getId());
+	}
+
+	void CachedFileSystem::evict()
+	{
+		// buffers still referenced by open views stay alive until those views close.
+		while (_stats.bytes > byteBudget && !recent.empty()) {
+			auto it = entries.find(recent.back());
+			_stats.bytes -= it->second.buffer->size();
+			entries.erase(it);
+			recent.pop_back();
+			_stats.evictions++;
+		}
+
+		_stats.entries = entries.size();
+	}
+};
@@ -0,0 +1,126 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include "GameFileSystem.h"
+
+namespace core {
+
+	/// <summary>
+	/// Read only view over a fully decompressed file, the buffer is shared with the cache and any other open views.
+	/// </summary>
+	class BufferedArchiveFile final : public ArchiveFile {
+	public:
+		using buffer_t = std::shared_ptr<const std::vector<uint8_t>>;
+
+		BufferedArchiveFile(const GameFileUri& uri, buffer_t buffer, GameFileSystem* source) :
+			ArchiveFile(uri), _buffer(std::move(buffer)), _source(source)
+		{}
+
+		uint64_t getFileSize() override {
+			return _buffer->size();
+		}
+
+		void read(void* dest, uint64_t bytes, uint64_t offset = 0) override;
+
+		std::span<const uint8_t> data() override {
+			return *_buffer;
+		}
+
+		// the database readers require a real file source, so the file is reopened from the underlying filesystem.
+		std::unique_ptr<WDBReader::Filesystem::FileSource> release() override;
+
+	protected:
+		buffer_t _buffer;
+		GameFileSystem* _source;
+	};
+
+	/// <summary>
+	/// Decorator which keeps the contents of recently opened files in memory, repeat opens of the same file are served from the shared buffer
+	/// instead of going back through CascLib/StormLib. Least recently used entries are evicted once the byte budget is exceeded.
+	/// </summary>
+	class CachedFileSystem final : public GameFileSystem
+	{
+	public:
+		struct Stats {
+			uint64_t hits = 0;
+			uint64_t misses = 0;
+			uint64_t evictions = 0;
+			size_t entries = 0;
+			size_t bytes = 0;
+		};
+
+		CachedFileSystem(std::unique_ptr<GameFileSystem> source, size_t byte_budget);
+		CachedFileSystem(CachedFileSystem&&) = delete;
+		virtual ~CachedFileSystem() {
+			waitForOpens();
+		}
+
+		constexpr QChar seperator() const override {
+			return _seperator;
+		}
+
+		std::future<void> load() override {
+			return _source->load();
+		}
+
+		std::unique_ptr<ArchiveFile> openFile(const GameFileUri& uri) override;
+		std::future<void> prefetch(std::span<const GameFileUri> uris) override;
+
+		std::unique_ptr<std::vector<GameFileUri::path_t>> fileList(std::function<bool(const GameFileUri::path_t&)> pred) override {
+			return _source->fileList(pred);
+		}
+
+		GameFileUri asFileId(const GameFileUri& uri) const override {
+			return _source->asFileId(uri);
+		}
+		GameFileUri asFilePath(const GameFileUri& uri) const override {
+			return _source->asFilePath(uri);
+		}
+		GameFileUri asInternal(const GameFileUri& uri) const override {
+			return _source->asInternal(uri);
+		}
+		GameFileUri asInternal(const GameFileInfo& info) const override {
+			return _source->asInternal(info);
+		}
+		GameFileInfo asInfo(const GameFileUri& uri) const override {
+			return _source->asInfo(uri);
+		}
+
+		GameFileSystem* source() const {
+			return _source.get();
+		}
+
+		Stats stats() const;
+		void clear();
+
+	protected:
+		using key_t = GameFileUri::variant_t;
+
+		struct Entry {
+			BufferedArchiveFile::buffer_t buffer;
+			std::list<key_t>::iterator position;
+		};
+
+		// files larger than this are passed through uncached, so a single large file (e.g database tables) cant flush the cache.
+		size_t maxEntryBytes() const {
+			return byteBudget / 8;
+		}
+
+		std::optional<key_t> makeKey(const GameFileUri& uri) const;
+		void evict();
+
+		std::unique_ptr<GameFileSystem> _source;
+		const QChar _seperator;
+		const size_t byteBudget;
+
+		mutable std::mutex mutex;
+		std::list<key_t> recent;	// most recently used at the front.
+		std::unordered_map<key_t, Entry> entries;
+		Stats _stats;
+	};
+};
@@ -1,12 +1,66 @@
 #include "../../stdafx.h"
 #include <QFile>
+#include <QSaveFile>
 #include "CascFileSystem.h"
 #include "../utility/Exceptions.h"
+#include "../utility/Logger.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
 #include <future>
 #include <fstream>
 
 namespace core {
-    CascFileSystem::CascFileSystem(const QString& root, const QString& locale, const QString& product, const QString& list_file) : GameFileSystem(root, locale), listFilePath(list_file) {
+
+    namespace {
+        // persisted availability bitmap, followed by the bits packed into uint64_t words.
+        struct AvailabilityHeader {
+            std::array<uint8_t, 4> magic;
+            uint32_t version;
+            uint32_t buildNumber;
+            int32_t locale;
+            uint32_t localFileCount;
+            uint32_t bitCount;
+        };
+
+        constexpr std::array<uint8_t, 4> AVAILABILITY_MAGIC = { 'W', 'C', 'A', 'B' };
+        constexpr uint32_t AVAILABILITY_VERSION = 1;
+
+        // reads straight from a disk cache entry, the mapping stays open for as long as the source.
+        class MappedFileSource final : public WDBReader::Filesystem::FileSource {
+        public:
+            MappedFileSource(DiskFileCache::Mapping mapping, std::string name) : mapping(std::move(mapping)), name(std::move(name)) {}
+
+            void read(void* dest, uint64_t bytes) override {
+                if (bytes > mapping.data.size() - std::min<uint64_t>(pos, mapping.data.size())) {
+                    throw FileIOException(name, "Attempted to read beyond end of file.");
+                }
+
+                memcpy(dest, mapping.data.data() + pos, bytes);
+                pos += bytes;
+            }
+
+            void setPos(uint64_t position) override {
+                pos = position;
+            }
+
+            uint64_t getPos() const override {
+                return pos;
+            }
+
+            uint64_t size() const override {
+                return mapping.data.size();
+            }
+
+        protected:
+            DiskFileCache::Mapping mapping;
+            std::string name;
+            uint64_t pos = 0;
+        };
+    }
+
+    CascFileSystem::CascFileSystem(const QString& root, const QString& locale, const QString& product, const QString& list_file) : GameFileSystem(root, locale), listFilePath(list_file), productName(product) {
 
         cascLocale = WDBReader::Filesystem::CASCLocaleConvert(locale.toStdString());
 
@@ -47,49 +101,56 @@ namespace core {
         }
 
         addExtraEncryptionKeys();
+
+        {
+            CASC_STORAGE_PRODUCT product_info = {};
+            if (CascGetStorageInfo(_impl->getHandle(), CascStorageProduct, &product_info, sizeof(product_info), nullptr)) {
+                buildNumber = product_info.BuildNumber;
+            }
+            else {
+                buildNumber = 0;
+            }
+
+            // changes as the launcher downloads more of a partial install, invalidating the persisted availability.
+            DWORD local_files = 0;
+            if (CascGetStorageInfo(_impl->getHandle(), CascStorageLocalFileCount, &local_files, sizeof(local_files), nullptr)) {
+                localFileCount = local_files;
+            }
+            else {
+                localFileCount = 0;
+            }
+        }
     }
 
     std::future<void> CascFileSystem::load()
     {
-        QFile list(listFilePath);
+        // the compiled index is either mapped directly, or built from the csv on first use - either way it is ready before returning.
+        listFileIndex = ListFileIndex::open(listFilePath);
 
-        std::vector<std::pair<QString, qsizetype>> queued_lines;
-        
-        if (list.open(QIODevice::ReadOnly | QIODevice::Text))
-        {
-            queued_lines.reserve(10000);
+        // availability is only needed when listing files, so can be finished in the background.
+        fileAvailabilityReady = std::async(std::launch::async, [this]() {
+            buildFileAvailability();
+        }).share();
 
-            QTextStream in(&list);
+        return std::async(std::launch::deferred, [ready = fileAvailabilityReady]() {
+            ready.get();
+        });
+    }
 
-            while (!in.atEnd())
-            {
-                QString line = in.readLine();
-                const auto first_index = line.indexOf(';');
-
-                if (first_index > 0) {
-                    if (line.endsWith(".db2")) {
-                        addFileMappingFromLine(line, first_index);
-                    }
-                    else {
-                        queued_lines.emplace_back(line, first_index);
-                    }
-                }
-            }
-        }
-        else {
-            throw FileIOException(listFilePath.toStdString(), "Unable to load list file.");
+    void CascFileSystem::enableDiskCache(const QString& directory, uint64_t byte_budget)
+    {
+        if (byte_budget == 0) {
+            diskCache.reset();
+            return;
         }
 
-        const auto queued_size = queued_lines.size();
-        idToFileNameMap.reserve(queued_size);
-        fileNameToIdMap.reserve(queued_size);
-
-        return std::async(std::launch::async, [&](std::vector<std::pair<QString, qsizetype>>&& lines) {
+        if (buildNumber == 0) {
+            // without a build number, entries from different client versions couldnt be told apart.
+            Log::message("Unable to determine casc build number, disk cache disabled.");
+            return;
+        }
 
-            for (auto it = lines.begin(); it != lines.end(); ++it) {
-                addFileMappingFromLine(it->first, it->second);
-            }
-        }, std::move(queued_lines));
+        diskCache = std::make_unique<DiskFileCache>(directory, byte_budget);
     }
 
     std::unique_ptr<ArchiveFile> CascFileSystem::openFile(const GameFileUri& uri)
@@ -102,13 +163,13 @@ namespace core {
                     return var;
                 }
                 else if constexpr (std::is_same_v<const GameFileUri::path_t&, decltype(var)>) {
-                    return fileNameToIdMap[var];
+                    return findFileId(var);
                 }
                 return 0;
                 }, uri);
 
         }
-        catch (std::exception e) {
+        catch (const std::exception&) {
             id = 0;
         }
 
@@ -116,9 +177,19 @@ namespace core {
             return nullptr;
         }
 
+        QString cache_key;
+        if (diskCache) {
+            cache_key = diskCacheKey(id);
+            auto mapping = diskCache->open(cache_key);
+            if (mapping.has_value()) {
+                return std::make_unique<DiskCachedCascFile>(uri, std::move(*mapping));
+            }
+        }
+
+        // casclib supports concurrent opens/reads against the same storage, as long as each thread uses its own file handle.
         auto raw = _impl->open(id);
         if (raw != nullptr) {
-            return std::make_unique<CascFile>(uri, std::move(raw));
+            return std::make_unique<CascFile>(uri, std::move(raw), diskCache.get(), std::move(cache_key));
         }
         
         return nullptr;
@@ -127,60 +198,61 @@ namespace core {
 
     std::unique_ptr<std::vector<GameFileUri::path_t>> CascFileSystem::fileList(std::function<bool(const GameFileUri::path_t&)> pred)
     {
+        if (fileAvailabilityReady.valid()) {
+            fileAvailabilityReady.wait();
+        }
+
         auto list_items = std::make_unique<std::vector<QString>>(); 
 
-        for (auto it = fileNameToIdMap.begin(); it != fileNameToIdMap.end(); ++it) {
-            if (pred(it->first)) {
-                HANDLE temp;
-                if (CascOpenFile(_impl->getHandle(), CASC_FILE_DATA_ID(it->second), CASC_LOCALE_ALL, CASC_OPEN_BY_FILEID, &temp)) { 
-                    list_items->push_back(it->first);
-                    CascCloseFile(temp);
-                }
+        listFileIndex.forEach([&](GameFileUri::id_t id, std::string_view path) {
+            auto name = QString::fromUtf8(path.data(), path.size());
+            if (pred(name) && isFileAvailable(id)) {
+                list_items->push_back(std::move(name));
             }
-        }
+        });
 
         return std::move(list_items);
     }
 
-    GameFileUri CascFileSystem::asFileId(const GameFileUri& uri)
+    GameFileUri CascFileSystem::asFileId(const GameFileUri& uri) const
     {
         if (uri.isPath()) {
-            return fileNameToIdMap[uri.getPath()];
+            return findFileId(uri.getPath());
         }
 
         return uri;
     }
 
-    GameFileUri CascFileSystem::asFilePath(const GameFileUri& uri)
+    GameFileUri CascFileSystem::asFilePath(const GameFileUri& uri) const
     {
         if (uri.isId()) {
-            return idToFileNameMap[uri.getId()];
+            return findFilePath(uri.getId());
         }
 
         return uri;
     }
 
-    GameFileUri CascFileSystem::asInternal(const GameFileUri& uri)
+    GameFileUri CascFileSystem::asInternal(const GameFileUri& uri) const
     {
         return asFileId(uri);
     }
 
-    GameFileUri CascFileSystem::asInternal(const GameFileInfo& info)
+    GameFileUri CascFileSystem::asInternal(const GameFileInfo& info) const
     {
         return info.id;
     }
 
-    GameFileInfo CascFileSystem::asInfo(const GameFileUri& uri)
+    GameFileInfo CascFileSystem::asInfo(const GameFileUri& uri) const
     {
         auto info = GameFileInfo();
 
         if (uri.isId()) {
             info.id = uri.getId();
-            info.path = idToFileNameMap[info.id];
+            info.path = findFilePath(info.id);
         }
         else {
             info.path = uri.getPath();
-            info.id = fileNameToIdMap[info.path];
+            info.id = findFileId(info.path);
         }
 
         return info;
@@ -212,26 +284,154 @@ namespace core {
         }
     }
 
-    /*
-        specialist atoi implementation - must faster than regular conversion - see https://stackoverflow.com/questions/16826422/c-most-efficient-way-to-convert-string-to-int-faster-than-atoi
-        input must be only characters, this is fine as the listfile input is known.
-    */
-    uint32_t fast_atoi(const char* str)
+    GameFileUri::id_t CascFileSystem::findFileId(const GameFileUri::path_t& path) const
     {
-        uint32_t val = 0;
-        while (*str) {
-            val = val * 10 + (*str++ - '0');
+        return listFileIndex.findId(path).value_or(0);
+    }
+
+    GameFileUri::path_t CascFileSystem::findFilePath(GameFileUri::id_t id) const
+    {
+        const auto path = listFileIndex.findPath(id);
+        if (path.has_value()) {
+            return QString::fromUtf8(path->data(), path->size());
         }
-        return val;
+
+        return "";
     }
 
-    inline void CascFileSystem::addFileMappingFromLine(const QString& line, qsizetype seperator_pos)
+    void CascFileSystem::buildFileAvailability()
     {
-        const GameFileUri::id_t id = fast_atoi(line.first(seperator_pos).toStdString().c_str());
-        const GameFileUri::path_t fileName = line.last(line.length() - (seperator_pos + 1)).toLower();
+        if (loadFileAvailability()) {
+            return;
+        }
+
+        std::vector<bool> available(listFileIndex.maxId() + 1, false);
+        size_t available_count = 0;
+
+        CASC_FIND_DATA find_data;
+        HANDLE find = CascFindFirstFile(_impl->getHandle(), "*", &find_data, nullptr);
+
+        if (find != nullptr && find != INVALID_HANDLE_VALUE) {
+            do {
+                if (!find_data.bFileAvailable || find_data.dwFileDataId == CASC_INVALID_ID) {
+                    continue;
+                }
+
+                if (find_data.dwFileDataId >= available.size()) {
+                    available.resize(std::max<size_t>(find_data.dwFileDataId + 1, available.size() * 2), false);
+                }
+
+                if (!available[find_data.dwFileDataId]) {
+                    available[find_data.dwFileDataId] = true;
+                    available_count++;
+                }
+            } while (CascFindNextFile(find, &find_data));
 
-        fileNameToIdMap[fileName] = id;
-        idToFileNameMap[id] = fileName;
+            CascFindClose(find);
+        }
+
+        if (available_count == 0) {
+            // storage doesnt support enumeration, fallback to checking files individually.
+            Log::message("Unable to enumerate casc storage, file availability will be checked on demand.");
+            available.clear();
+        }
+
+        fileAvailability = std::move(available);
+        saveFileAvailability();
+    }
+
+    bool CascFileSystem::loadFileAvailability()
+    {
+        if (buildNumber == 0) {
+            return false;
+        }
+
+        QFile file(availabilityPath());
+        if (!file.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+
+        const QByteArray content = file.readAll();
+        if ((size_t)content.size() < sizeof(AvailabilityHeader)) {
+            return false;
+        }
+
+        AvailabilityHeader header;
+        memcpy(&header, content.constData(), sizeof(header));
+
+        const bool matches =
+            header.magic == AVAILABILITY_MAGIC &&
+            header.version == AVAILABILITY_VERSION &&
+            header.buildNumber == buildNumber &&
+            header.locale == cascLocale &&
+            header.localFileCount == localFileCount;
+
+        const size_t word_count = ((size_t)header.bitCount + 63) / 64;
+        if (!matches || header.bitCount == 0 || (size_t)content.size() != sizeof(header) + (word_count * sizeof(uint64_t))) {
+            return false;
+        }
+
+        std::vector<bool> available(header.bitCount, false);
+        const char* words = content.constData() + sizeof(header);
+
+        for (size_t w = 0; w < word_count; w++) {
+            uint64_t word;
+            memcpy(&word, words + (w * sizeof(word)), sizeof(word));
+
+            while (word != 0) {
+                available[(w * 64) + std::countr_zero(word)] = true;
+                word &= word - 1;
+            }
+        }
+
+        fileAvailability = std::move(available);
+        return true;
+    }
+
+    void CascFileSystem::saveFileAvailability() const
+    {
+        // an empty bitmap means availability is checked on demand, which isnt worth persisting.
+        if (buildNumber == 0 || fileAvailability.empty()) {
+            return;
+        }
+
+        AvailabilityHeader header;
+        header.magic = AVAILABILITY_MAGIC;
+        header.version = AVAILABILITY_VERSION;
+        header.buildNumber = buildNumber;
+        header.locale = cascLocale;
+        header.localFileCount = localFileCount;
+        header.bitCount = (uint32_t)fileAvailability.size();
+
+        std::vector<uint64_t> words((fileAvailability.size() + 63) / 64, 0);
+        for (size_t i = 0; i < fileAvailability.size(); i++) {
+            if (fileAvailability[i]) {
+                words[i / 64] |= uint64_t(1) << (i % 64);
+            }
+        }
+
+        QSaveFile out(availabilityPath());
+        if (!(out.open(QIODevice::WriteOnly) &&
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header)) == (qint64)sizeof(header) &&
+            out.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint64_t)) == (qint64)(words.size() * sizeof(uint64_t)) &&
+            out.commit())) {
+            Log::message("Unable to persist casc file availability - " + availabilityPath());
+        }
+    }
+
+    bool CascFileSystem::isFileAvailable(GameFileUri::id_t id) const
+    {
+        if (!fileAvailability.empty()) {
+            return id < fileAvailability.size() && fileAvailability[id];
+        }
+
+        HANDLE temp;
+        if (CascOpenFile(_impl->getHandle(), CASC_FILE_DATA_ID(id), CASC_LOCALE_ALL, CASC_OPEN_BY_FILEID, &temp)) {
+            CascCloseFile(temp);
+            return true;
+        }
+
+        return false;
     }
 
     uint64_t CascFile::getFileSize()
@@ -245,4 +445,32 @@ namespace core {
         _impl->read(dest, bytes);
     }
 
+    std::span<const uint8_t> CascFile::data()
+    {
+        const auto content = ArchiveFile::data();
+
+        if (diskCache != nullptr) {
+            diskCache->store(diskCacheKey, content);
+            diskCache = nullptr;
+        }
+
+        return content;
+    }
+
+    void DiskCachedCascFile::read(void* dest, uint64_t bytes, uint64_t offset)
+    {
+        if (offset + bytes > _mapping.data.size()) {
+            throw FileIOException(_uri.toString().toStdString(), "Attempted to read beyond end of file.");
+        }
+
+        memcpy(dest, _mapping.data.data() + offset, bytes);
+    }
+
+    std::unique_ptr<WDBReader::Filesystem::FileSource> DiskCachedCascFile::release()
+    {
+        auto source = std::make_unique<MappedFileSource>(std::move(_mapping), _uri.toString().toStdString());
+        _mapping = {};
+        return source;
+    }
+
 }
\ No newline at end of file
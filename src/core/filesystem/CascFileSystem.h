@@ -3,14 +3,17 @@
 #include <functional>
 #include <memory>
 #include <map>
+#include <optional>
 #include "GameFileSystem.h"
+#include "DiskFileCache.h"
+#include "ListFileIndex.h"
 #include <WDBReader/Filesystem/CASCFilesystem.hpp>
 
 namespace core {
 	class CascFile final : public ArchiveFile {
 	public:
-		CascFile(const GameFileUri& uri, std::unique_ptr<WDBReader::Filesystem::CASCFileSource> source) :
-			_impl(std::move(source)), ArchiveFile(uri)
+		CascFile(const GameFileUri& uri, std::unique_ptr<WDBReader::Filesystem::CASCFileSource> source, DiskFileCache* disk_cache = nullptr, QString disk_cache_key = QString()) :
+			_impl(std::move(source)), diskCache(disk_cache), diskCacheKey(std::move(disk_cache_key)), ArchiveFile(uri)
 		{}
 		uint64_t getFileSize() override;
 		void read(void* dest, uint64_t bytes, uint64_t offset = 0) override;
@@ -18,8 +21,37 @@ namespace core {
 			return std::move(_impl);
 		}
 
+		// files read in full are queued for the disk cache (if enabled), so later sessions can skip decoding them.
+		std::span<const uint8_t> data() override;
+
 	protected:
 		std::unique_ptr<WDBReader::Filesystem::CASCFileSource> _impl;
+		DiskFileCache* diskCache;
+		QString diskCacheKey;
+	};
+
+	/// <summary>
+	/// File served from the disk cache, read directly from the mapped cache entry.
+	/// </summary>
+	class DiskCachedCascFile final : public ArchiveFile {
+	public:
+		DiskCachedCascFile(const GameFileUri& uri, DiskFileCache::Mapping mapping) :
+			_mapping(std::move(mapping)), ArchiveFile(uri)
+		{}
+		uint64_t getFileSize() override {
+			return _mapping.data.size();
+		}
+		void read(void* dest, uint64_t bytes, uint64_t offset = 0) override;
+
+		// ownership of the mapping moves to the returned source, so database readers also skip decoding.
+		std::unique_ptr<WDBReader::Filesystem::FileSource> release() override;
+
+		std::span<const uint8_t> data() override {
+			return _mapping.data;
+		}
+
+	protected:
+		DiskFileCache::Mapping _mapping;
 	};
 
 	class CascFileSystem final : public GameFileSystem
@@ -27,7 +59,9 @@ namespace core {
 	public:
 		CascFileSystem(const QString& root, const QString& locale, const QString& product, const QString& list_file);
 		CascFileSystem(CascFileSystem&&) = default;
-		virtual ~CascFileSystem() = default;
+		virtual ~CascFileSystem() {
+			waitForOpens();
+		}
 
 		constexpr QChar seperator() const override {
 			return '/';
@@ -35,24 +69,59 @@ namespace core {
 
 		std::future<void> load() override;
 
+		// opt in to the persistent cache of decoded files, entries are keyed by build number and file id.
+		void enableDiskCache(const QString& directory, uint64_t byte_budget);
+
+		// stats of the disk cache, if enabled.
+		std::optional<DiskFileCache::Stats> diskCacheStats() const {
+			if (diskCache == nullptr) {
+				return std::nullopt;
+			}
+
+			return diskCache->stats();
+		}
+
 		std::unique_ptr<ArchiveFile> openFile(const GameFileUri& uri) override;
 		std::unique_ptr<std::vector<GameFileUri::path_t>> fileList(std::function<bool(const GameFileUri::path_t&)> pred) override;
 
-		GameFileUri asFileId(const GameFileUri& uri) override;
-		GameFileUri asFilePath(const GameFileUri& uri) override;
-		GameFileUri asInternal(const GameFileUri& uri) override;
-		GameFileUri asInternal(const GameFileInfo& info) override;
-		GameFileInfo asInfo(const GameFileUri& uri) override;
+		GameFileUri asFileId(const GameFileUri& uri) const override;
+		GameFileUri asFilePath(const GameFileUri& uri) const override;
+		GameFileUri asInternal(const GameFileUri& uri) const override;
+		GameFileUri asInternal(const GameFileInfo& info) const override;
+		GameFileInfo asInfo(const GameFileUri& uri) const override;
 
 	protected:
 		void addExtraEncryptionKeys();
-		inline void addFileMappingFromLine(const QString& line, qsizetype seperator_pos);
+
+		GameFileUri::id_t findFileId(const GameFileUri::path_t& path) const;
+		GameFileUri::path_t findFilePath(GameFileUri::id_t id) const;
+
+		// bitmap of file ids present in local storage, built from the casc root table rather than opening each file.
+		void buildFileAvailability();
+		bool isFileAvailable(GameFileUri::id_t id) const;
+
+		// the bitmap is persisted next to the listfile index, and reused while the build, locale and local file count match.
+		bool loadFileAvailability();
+		void saveFileAvailability() const;
+
+		inline QString availabilityPath() const {
+			return ListFileIndex::indexPath(listFilePath) + "." + productName + ".avail";
+		}
+
+		QString diskCacheKey(GameFileUri::id_t id) const {
+			return QString("%1/%2").arg(buildNumber).arg(id);
+		}
 
 		std::unique_ptr<WDBReader::Filesystem::CASCFilesystem> _impl;
-		std::unordered_map<GameFileUri::path_t, GameFileUri::id_t> fileNameToIdMap;
-		std::unordered_map<GameFileUri::id_t, GameFileUri::path_t> idToFileNameMap;
+		std::unique_ptr<DiskFileCache> diskCache;
+		uint32_t buildNumber;
+		uint32_t localFileCount;
+		ListFileIndex listFileIndex;
+		std::vector<bool> fileAvailability;
+		std::shared_future<void> fileAvailabilityReady;	// fileAvailability must not be read until this has completed.
 
 		const QString listFilePath;
+		const QString productName;
 		int cascLocale;
 	};
 
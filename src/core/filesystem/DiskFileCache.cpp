@@ -0,0 +1,171 @@
+#include "../../stdafx.h"
+#include "DiskFileCache.h"
+#include "../utility/Logger.h"
+#include <algorithm>
+#include <vector>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QSaveFile>
+
+namespace core {
+
+	DiskFileCache::DiskFileCache(const QString& directory, uint64_t byte_budget) :
+		directory(QDir(directory).absolutePath()),
+		byteBudget(byte_budget),
+		writePool(std::make_unique<QThreadPool>())
+	{
+		writePool->setMaxThreadCount(1);
+		QDir().mkpath(this->directory);
+		scan();
+	}
+
+	DiskFileCache::~DiskFileCache()
+	{
+		writePool->waitForDone();
+	}
+
+	std::optional<DiskFileCache::Mapping> DiskFileCache::open(const QString& key)
+	{
+		{
+			std::scoped_lock lock(mutex);
+			auto it = entries.find(key);
+			if (it == entries.end()) {
+				_stats.misses++;
+				return std::nullopt;
+			}
+
+			it->second.lastUsed = QDateTime::currentMSecsSinceEpoch();
+			_stats.hits++;
+		}
+
+		auto file = std::make_unique<QFile>(entryPath(key));
+		const auto size = file->size();
+		if (size > 0 && file->open(QFile::ReadOnly)) {
+			const uchar* data = file->map(0, size);
+			if (data != nullptr) {
+				// recency is persisted through the modified time (where the platform allows it on a read only handle), so eviction order survives restarts.
+				file->setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+				return Mapping{ std::move(file), std::span<const uint8_t>(data, size) };
+			}
+		}
+
+		// entry was removed or damaged outside of the cache, forget it.
+		std::scoped_lock lock(mutex);
+		auto it = entries.find(key);
+		if (it != entries.end()) {
+			_stats.bytes -= it->second.size;
+			entries.erase(it);
+			_stats.entries = entries.size();
+		}
+		_stats.hits--;
+		_stats.misses++;
+
+		return std::nullopt;
+	}
+
+	void DiskFileCache::store(const QString& key, std::span<const uint8_t> content)
+	{
+		if (content.empty() || content.size() > evictionTarget()) {
+			return;
+		}
+
+		{
+			std::scoped_lock lock(mutex);
+			if (entries.contains(key) || !pending.insert(key).second) {
+				return;
+			}
+		}
+
+		auto buffer = std::make_shared<std::vector<uint8_t>>(content.begin(), content.end());
+		writePool->start([this, key, buffer]() {
+			write(key, *buffer);
+
+			std::scoped_lock lock(mutex);
+			pending.erase(key);
+		});
+	}
+
+	void DiskFileCache::write(const QString& key, const std::vector<uint8_t>& content)
+	{
+		const QString path = entryPath(key);
+		QDir().mkpath(QFileInfo(path).absolutePath());
+
+		QSaveFile out(path);
+		if (!out.open(QIODevice::WriteOnly) ||
+			out.write(reinterpret_cast<const char*>(content.data()), content.size()) != static_cast<qint64>(content.size()) ||
+			!out.commit()) {
+			Log::message("Unable to write disk cache entry: " + path);
+			return;
+		}
+
+		std::scoped_lock lock(mutex);
+		auto [it, inserted] = entries.emplace(key, Entry{ content.size(), QDateTime::currentMSecsSinceEpoch() });
+		if (inserted) {
+			_stats.bytes += content.size();
+			_stats.entries = entries.size();
+			evict();
+		}
+	}
+
+	DiskFileCache::Stats DiskFileCache::stats() const
+	{
+		std::scoped_lock lock(mutex);
+		return _stats;
+	}
+
+	void DiskFileCache::scan()
+	{
+		QDirIterator it(directory, QDir::Files, QDirIterator::Subdirectories);
+		const QDir root(directory);
+
+		while (it.hasNext()) {
+			it.next();
+			const auto info = it.fileInfo();
+			entries.emplace(root.relativeFilePath(info.absoluteFilePath()), Entry{
+				static_cast<uint64_t>(info.size()),
+				info.lastModified().toMSecsSinceEpoch()
+			});
+			_stats.bytes += info.size();
+		}
+
+		_stats.entries = entries.size();
+
+		if (_stats.bytes > byteBudget) {
+			evict();
+		}
+	}
+
+	void DiskFileCache::evict()
+	{
+		if (_stats.bytes <= byteBudget) {
+			return;
+		}
+
+		std::vector<std::unordered_map<QString, Entry>::iterator> candidates;
+		candidates.reserve(entries.size());
+		for (auto it = entries.begin(); it != entries.end(); ++it) {
+			candidates.push_back(it);
+		}
+
+		std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+			return a->second.lastUsed < b->second.lastUsed;
+		});
+
+		for (auto& candidate : candidates) {
+			if (_stats.bytes <= evictionTarget()) {
+				break;
+			}
+
+			// files still mapped by an open reader cant be removed on all platforms, those are left for a later pass.
+			if (QFile::remove(entryPath(candidate->first))) {
+				_stats.bytes -= candidate->second.size;
+				_stats.evictions++;
+				entries.erase(candidate);
+			}
+		}
+
+		_stats.entries = entries.size();
+	}
+};
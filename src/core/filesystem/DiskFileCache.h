@@ -0,0 +1,78 @@
+#pragma once
+#include <QFile>
+#include <QString>
+#include <QThreadPool>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace core {
+
+	/// <summary>
+	/// Persistent cache of decoded file content, stored as one file per entry beneath a directory.
+	/// Entries are read back as memory mapped views, the least recently used entries are deleted once the size cap is exceeded.
+	/// Keys are relative paths, callers are responsible for making them unique (e.g including a build number.)
+	/// Stores are written on a background thread, any still pending are finished before the cache is destroyed.
+	/// </summary>
+	class DiskFileCache {
+	public:
+		struct Stats {
+			uint64_t hits = 0;
+			uint64_t misses = 0;
+			uint64_t evictions = 0;
+			size_t entries = 0;
+			uint64_t bytes = 0;
+		};
+
+		struct Mapping {
+			std::unique_ptr<QFile> file;
+			std::span<const uint8_t> data;	// valid while 'file' is open.
+		};
+
+		DiskFileCache(const QString& directory, uint64_t byte_budget);
+		DiskFileCache(DiskFileCache&&) = delete;
+		virtual ~DiskFileCache();
+
+		std::optional<Mapping> open(const QString& key);
+
+		// content is copied and queued, so the caller isnt held up by the disk write.
+		void store(const QString& key, std::span<const uint8_t> content);
+
+		Stats stats() const;
+
+	protected:
+		struct Entry {
+			uint64_t size;
+			int64_t lastUsed;
+		};
+
+		// once over budget, entries are removed until usage drops to this, to avoid evicting on every store.
+		uint64_t evictionTarget() const {
+			return byteBudget - (byteBudget / 10);
+		}
+
+		QString entryPath(const QString& key) const {
+			return directory + "/" + key;
+		}
+
+		void write(const QString& key, const std::vector<uint8_t>& content);
+		void scan();
+		void evict();
+
+		const QString directory;
+		const uint64_t byteBudget;
+
+		mutable std::mutex mutex;
+		std::unordered_map<QString, Entry> entries;
+		std::unordered_set<QString> pending;	// keys queued but not yet written.
+		Stats _stats;
+
+		// a single thread, writes are disk bound and shouldnt compete with file decoding.
+		std::unique_ptr<QThreadPool> writePool;
+	};
+};
@@ -1,28 +1,76 @@
 #pragma once
 
 #include <QString>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
 #include <memory>
 #include <future>
+#include <span>
+#include <vector>
 #include "GameFileUri.h"
 #include <WDBReader/Filesystem.hpp>
 
 namespace core {
 
+	/// <summary>
+	/// A single open file, instances are not thread safe and should only be used by one thread at a time.
+	/// </summary>
 	class ArchiveFile {
 	public:
 		virtual ~ArchiveFile() {}
 		virtual uint64_t getFileSize() = 0;
 		virtual void read(void* dest, uint64_t bytes, uint64_t offset = 0) = 0;
 		virtual std::unique_ptr<WDBReader::Filesystem::FileSource> release() = 0;
+
+		/// <summary>
+		/// View over the complete decompressed content of the file, valid for the lifetime of the ArchiveFile.
+		/// Files already held in memory return their buffer directly, otherwise the content is read once on first use.
+		/// </summary>
+		virtual std::span<const uint8_t> data() {
+			if (!_contentsLoaded) {
+				_contents.resize(getFileSize());
+				read(_contents.data(), _contents.size());
+				_contentsLoaded = true;
+			}
+
+			return _contents;
+		}
+
+		/// <summary>
+		/// Moves the complete content out of the file, data() should not be used afterwards.
+		/// Content read through the base data() is handed over without a copy, other buffers (e.g mapped or shared) are copied.
+		/// </summary>
+		virtual std::vector<uint8_t> takeData() {
+			const auto content = data();
+			if (_contentsLoaded && content.data() == _contents.data()) {
+				_contentsLoaded = false;
+				return std::move(_contents);
+			}
+
+			return std::vector<uint8_t>(content.begin(), content.end());
+		}
+
 	protected:
 		ArchiveFile(const GameFileUri& uri) : _uri(uri) {}
 		GameFileUri _uri;
+
+	private:
+		std::vector<uint8_t> _contents;
+		bool _contentsLoaded = false;
 	};
 
+	/// <summary>
+	/// Thread safety - after load() has been called, all members may be called concurrently from any thread.
+	/// uri conversions are const and never modify the filesystem, openFile may be used to open the same or different files from multiple threads,
+	/// backends are responsible for serialising access to any underlying archive state which isnt safe to share.
+	/// </summary>
 	class GameFileSystem {
 	public:
-		GameFileSystem(const QString& root, const QString& locale) {
+		GameFileSystem(const QString& root, const QString& locale) : openPool(std::make_unique<QThreadPool>()) {
 			rootDirectory = root;
+			// reads mostly wait on the disk, so a few more threads than cores are worthwhile.
+			openPool->setMaxThreadCount(std::clamp(QThread::idealThreadCount() * 2, 4, 16));
 		};
 
 		GameFileSystem(GameFileSystem&&) = default;
@@ -37,18 +85,68 @@ namespace core {
 		virtual std::future<void> load() = 0;
 
 		virtual std::unique_ptr<ArchiveFile> openFile(const GameFileUri& uri) = 0;
+
+		/// <summary>
+		/// Open several files concurrently, each file is opened and has its content read on the filesystems own thread pool.
+		/// Futures are in the same order as the uris, files which cannot be opened resolve to nullptr.
+		/// </summary>
+		std::vector<std::future<std::unique_ptr<ArchiveFile>>> openFiles(std::span<const GameFileUri> uris) {
+			std::vector<std::future<std::unique_ptr<ArchiveFile>>> result;
+			result.reserve(uris.size());
+
+			for (const auto& uri : uris) {
+				auto promise = std::make_shared<std::promise<std::unique_ptr<ArchiveFile>>>();
+				result.push_back(promise->get_future());
+
+				openPool->start([this, uri, promise]() {
+					try {
+						auto file = openFile(uri);
+						if (file != nullptr) {
+							file->data();
+						}
+						promise->set_value(std::move(file));
+					}
+					catch (...) {
+						promise->set_exception(std::current_exception());
+					}
+				});
+			}
+
+			return result;
+		}
+
+		/// <summary>
+		/// Hint that the files will be opened soon, so they can be loaded ahead of time.
+		/// Only filesystems which keep file content (e.g CachedFileSystem) benefit, by default this is a no-op and returns an invalid future.
+		/// The returned future is ready once the prefetch has finished, it does not need to be waited on.
+		/// </summary>
+		virtual std::future<void> prefetch(std::span<const GameFileUri> uris) {
+			return std::future<void>();
+		}
 		virtual std::unique_ptr<std::vector<GameFileUri::path_t>> fileList(std::function<bool(const GameFileUri::path_t&)> pred) = 0;
 
 		// uri conversions:
-		virtual GameFileUri asFileId(const GameFileUri& uri) = 0;
-		virtual GameFileUri asFilePath(const GameFileUri& uri) = 0;
+		virtual GameFileUri asFileId(const GameFileUri& uri) const = 0;
+		virtual GameFileUri asFilePath(const GameFileUri& uri) const = 0;
 		// Convert to the filesystem perferred format.
-		virtual GameFileUri asInternal(const GameFileUri& uri) = 0;
-		virtual GameFileUri asInternal(const GameFileInfo& info) = 0;
-		virtual GameFileInfo asInfo(const GameFileUri& uri) = 0;
+		virtual GameFileUri asInternal(const GameFileUri& uri) const = 0;
+		virtual GameFileUri asInternal(const GameFileInfo& info) const = 0;
+		virtual GameFileInfo asInfo(const GameFileUri& uri) const = 0;
 
 	protected:
+		// drops queued opens and waits for running ones, futures of dropped opens report std::future_errc::broken_promise.
+		// opens call back into the derived filesystem, so each final filesystem must call this from its destructor.
+		void waitForOpens() {
+			if (openPool) {
+				openPool->clear();
+				openPool->waitForDone();
+			}
+		}
+
 		QString rootDirectory;
+
+		// worker threads for openFiles / prefetch, bounded so loading a model with many dependants doesnt start a thread for each file.
+		std::unique_ptr<QThreadPool> openPool;
 	};
 
 };
\ No newline at end of file
@@ -0,0 +1,482 @@
+#include "../../stdafx.h"
+#include "ListFileIndex.h"
+#include "../utility/Exceptions.h"
+#include "../utility/Logger.h"
+#include <algorithm>
+#include <charconv>
+#include <thread>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtConcurrent>
+
+namespace core {
+
+	namespace {
+
+		template<typename T, typename fn>
+		void forEachChunk(std::vector<T>& items, bool parallel, fn callback) {
+			if (parallel && items.size() > 1) {
+				QtConcurrent::blockingMap(items, callback);
+			}
+			else {
+				std::for_each(items.begin(), items.end(), callback);
+			}
+		}
+
+		// ranges of the vector are sorted concurrently, then neighbouring ranges are merged pairwise until one remains.
+		template<typename T, typename compare>
+		void sortChunked(std::vector<T>& values, size_t chunk_count, compare comp) {
+			if (chunk_count <= 1 || values.size() < chunk_count) {
+				std::sort(values.begin(), values.end(), comp);
+				return;
+			}
+
+			struct Range {
+				size_t begin;
+				size_t middle;
+				size_t end;
+			};
+
+			std::vector<size_t> bounds;
+			for (size_t i = 0; i <= chunk_count; i++) {
+				bounds.push_back((values.size() * i) / chunk_count);
+			}
+
+			std::vector<Range> ranges;
+			for (size_t i = 0; i + 1 < bounds.size(); i++) {
+				ranges.push_back({ bounds[i], bounds[i + 1], bounds[i + 1] });
+			}
+
+			QtConcurrent::blockingMap(ranges, [&values, &comp](const Range& range) {
+				std::sort(values.begin() + range.begin, values.begin() + range.end, comp);
+			});
+
+			while (bounds.size() > 2) {
+				std::vector<Range> merges;
+				std::vector<size_t> next_bounds;
+
+				for (size_t i = 0; i + 2 < bounds.size(); i += 2) {
+					merges.push_back({ bounds[i], bounds[i + 1], bounds[i + 2] });
+					next_bounds.push_back(bounds[i]);
+				}
+
+				// with an odd number of ranges, the last is carried over to the next round.
+				if (bounds.size() % 2 == 0) {
+					next_bounds.push_back(bounds[bounds.size() - 2]);
+				}
+				next_bounds.push_back(bounds.back());
+
+				forEachChunk(merges, true, [&values, &comp](const Range& range) {
+					std::inplace_merge(values.begin() + range.begin, values.begin() + range.middle, values.begin() + range.end, comp);
+				});
+
+				bounds = std::move(next_bounds);
+			}
+		}
+	}
+
+	uint64_t ListFileIndex::hashPath(std::string_view path)
+	{
+		if (!isAscii(path)) {
+			return hashPath(QStringView(QString::fromUtf8(path.data(), path.size())));
+		}
+
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (const char c : path) {
+			hash ^= static_cast<uint8_t>(foldCase(c));
+			hash *= 0x100000001b3ull;
+		}
+		return hash != EMPTY_HASH ? hash : 1;
+	}
+
+	uint64_t ListFileIndex::hashPath(QStringView path)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		visitFolded(path, [&hash](uint8_t c) {
+			hash ^= c;
+			hash *= 0x100000001b3ull;
+			return true;
+		});
+		return hash != EMPTY_HASH ? hash : 1;
+	}
+
+	ListFileIndex ListFileIndex::open(const QString& csv_path)
+	{
+		const QFileInfo csv_info(csv_path);
+		if (!csv_info.exists()) {
+			throw FileIOException(csv_path.toStdString(), "Unable to load list file.");
+		}
+
+		const uint64_t source_size = csv_info.size();
+		const int64_t source_modified = csv_info.lastModified().toMSecsSinceEpoch();
+		const QString index_path = indexPath(csv_path);
+
+		ListFileIndex index;
+
+		if (index.mapFile(index_path) &&
+			index._header->sourceSize == source_size &&
+			index._header->sourceModified == source_modified) {
+			return index;
+		}
+
+		index = ListFileIndex();
+
+		QElapsedTimer timer;
+		timer.start();
+
+		std::vector<uint8_t> image;
+		{
+			QFile csv(csv_path);
+			if (!csv.open(QIODevice::ReadOnly)) {
+				throw FileIOException(csv_path.toStdString(), "Unable to load list file.");
+			}
+
+			const auto csv_size = csv.size();
+			const uchar* csv_data = csv_size > 0 ? csv.map(0, csv_size) : nullptr;
+			if (csv_size > 0 && csv_data == nullptr) {
+				throw FileIOException(csv_path.toStdString(), "Unable to map list file.");
+			}
+
+			image = compile(std::span<const uint8_t>(csv_data, csv_data != nullptr ? csv_size : 0), source_size, source_modified);
+		}
+
+		Log::message(QString("Built listfile index in %1ms.").arg(timer.elapsed()));
+
+		QSaveFile out(index_path);
+		if (out.open(QIODevice::WriteOnly) &&
+			out.write(reinterpret_cast<const char*>(image.data()), image.size()) == (qint64)image.size() &&
+			out.commit()) {
+			if (index.mapFile(index_path)) {
+				return index;
+			}
+		}
+		else {
+			Log::message("Unable to persist listfile index - " + index_path);
+		}
+
+		index._owned = std::move(image);
+		if (!index.attach(index._owned.data(), index._owned.size())) {
+			throw FileIOException(index_path.toStdString(), "Invalid list file index.");
+		}
+
+		return index;
+	}
+
+	std::optional<GameFileUri::id_t> ListFileIndex::findId(const GameFileUri::path_t& path) const
+	{
+		const auto table = hashTable();
+		if (table.empty()) {
+			return std::nullopt;
+		}
+
+		const size_t mask = table.size() - 1;
+		const uint64_t hash = hashPath(QStringView(path));
+
+		for (size_t slot = hash & mask; table[slot].hash != EMPTY_HASH; slot = (slot + 1) & mask) {
+			if (table[slot].hash != hash) {
+				continue;
+			}
+
+			const auto stored = stringAt(table[slot].offset);
+			size_t pos = 0;
+			const bool matched = visitFolded(path, [&](uint8_t c) {
+				return pos < stored.size() && static_cast<uint8_t>(stored[pos++]) == c;
+			});
+
+			if (matched && pos == stored.size()) {
+				return table[slot].id;
+			}
+		}
+
+		return std::nullopt;
+	}
+
+	std::optional<std::string_view> ListFileIndex::findPath(GameFileUri::id_t id) const
+	{
+		const auto table = idTable();
+		const auto found = std::ranges::lower_bound(table, id, std::ranges::less{}, &IdEntry::id);
+
+		if (found != table.end() && found->id == id) {
+			return stringAt(found->offset);
+		}
+
+		return std::nullopt;
+	}
+
+	std::vector<uint8_t> ListFileIndex::compile(std::span<const uint8_t> csv, uint64_t source_size, int64_t source_modified, bool parallel)
+	{
+		std::vector<Chunk> chunks = splitChunks(csv, parallel ? std::max(1u, std::thread::hardware_concurrency()) : 1);
+
+		forEachChunk(chunks, parallel, parseChunk);
+
+		// each chunk is assigned a disjoint slice of the merged output, so the copy needs no synchronisation.
+		size_t record_total = 0;
+		size_t string_total = 0;
+		for (auto& chunk : chunks) {
+			chunk.recordBase = record_total;
+			chunk.stringBase = string_total;
+			record_total += chunk.records.size();
+			string_total += chunk.strings.size();
+		}
+
+		std::vector<Record> records(record_total);
+		std::vector<uint8_t> strings(string_total);
+
+		forEachChunk(chunks, parallel, [&records, &strings](Chunk& chunk) {
+			std::copy(chunk.strings.begin(), chunk.strings.end(), strings.begin() + chunk.stringBase);
+			std::transform(chunk.records.begin(), chunk.records.end(), records.begin() + chunk.recordBase, [&chunk](Record record) {
+				record.offset += static_cast<uint32_t>(chunk.stringBase);
+				record.line += static_cast<uint32_t>(chunk.recordBase);
+				return record;
+			});
+
+			chunk.records = {};
+			chunk.strings = {};
+		});
+
+		auto string_view_at = [&strings](uint32_t offset) -> std::string_view {
+			uint16_t length;
+			memcpy(&length, strings.data() + offset, sizeof(length));
+			return { reinterpret_cast<const char*>(strings.data() + offset + sizeof(length)), length };
+		};
+
+		// later lines take priority over earlier ones, for both the id and path lookups.
+
+		std::vector<IdEntry> id_table;
+		{
+			sortChunked(records, chunks.size(), [](const Record& a, const Record& b) {
+				return a.id != b.id ? a.id < b.id : a.line < b.line;
+			});
+
+			id_table.reserve(records.size());
+			for (size_t i = 0; i < records.size(); i++) {
+				if (i + 1 < records.size() && records[i + 1].id == records[i].id) {
+					continue;
+				}
+				id_table.push_back({ records[i].id, records[i].offset });
+			}
+		}
+
+		std::vector<HashEntry> hash_table(hashCapacity(records.size()), HashEntry{ EMPTY_HASH, 0, 0 });
+		{
+			sortChunked(records, chunks.size(), [](const Record& a, const Record& b) {
+				return a.hash != b.hash ? a.hash < b.hash : a.line < b.line;
+			});
+
+			const size_t mask = hash_table.size() - 1;
+
+			for (size_t i = 0; i < records.size(); i++) {
+				bool superseded = false;
+				for (size_t j = i + 1; j < records.size() && records[j].hash == records[i].hash; j++) {
+					if (string_view_at(records[j].offset) == string_view_at(records[i].offset)) {
+						superseded = true;
+						break;
+					}
+				}
+
+				if (!superseded) {
+					size_t slot = records[i].hash & mask;
+					while (hash_table[slot].hash != EMPTY_HASH) {
+						slot = (slot + 1) & mask;
+					}
+					hash_table[slot] = { records[i].hash, records[i].id, records[i].offset };
+				}
+			}
+		}
+
+		Header header;
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.sourceSize = source_size;
+		header.sourceModified = source_modified;
+		header.entryCount = static_cast<uint32_t>(id_table.size());
+		header.hashCapacity = static_cast<uint32_t>(hash_table.size());
+		header.hashTableOffset = sizeof(Header);
+		header.idTableOffset = header.hashTableOffset + (sizeof(HashEntry) * hash_table.size());
+		header.stringsOffset = header.idTableOffset + (sizeof(IdEntry) * id_table.size());
+		header.stringsSize = strings.size();
+
+		std::vector<uint8_t> image(header.stringsOffset + header.stringsSize);
+		memcpy(image.data(), &header, sizeof(header));
+		memcpy(image.data() + header.hashTableOffset, hash_table.data(), sizeof(HashEntry) * hash_table.size());
+		memcpy(image.data() + header.idTableOffset, id_table.data(), sizeof(IdEntry) * id_table.size());
+		memcpy(image.data() + header.stringsOffset, strings.data(), strings.size());
+
+		return image;
+	}
+
+	std::vector<ListFileIndex::Chunk> ListFileIndex::splitChunks(std::span<const uint8_t> csv, size_t max_chunks)
+	{
+		const char* const begin = reinterpret_cast<const char*>(csv.data());
+		const char* const end = begin + csv.size();
+
+		const size_t chunk_count = std::clamp<size_t>(max_chunks, 1, std::max<size_t>(1, csv.size() / MIN_CHUNK_BYTES));
+		const size_t chunk_size = csv.size() / chunk_count;
+
+		std::vector<Chunk> chunks;
+		chunks.reserve(chunk_count);
+
+		const char* chunk_begin = begin;
+		for (size_t i = 1; i < chunk_count && chunk_begin < end; i++) {
+			const char* target = std::max(begin + (i * chunk_size), chunk_begin);
+			const char* eol = static_cast<const char*>(memchr(target, '\n', end - target));
+			const char* chunk_end = eol != nullptr ? eol + 1 : end;
+
+			chunks.push_back({ chunk_begin, chunk_end });
+			chunk_begin = chunk_end;
+		}
+
+		if (chunk_begin < end || chunks.empty()) {
+			chunks.push_back({ chunk_begin, end });
+		}
+
+		return chunks;
+	}
+
+	void ListFileIndex::parseChunk(Chunk& chunk)
+	{
+		// rough estimate based on the average line length of the community listfile.
+		const size_t chunk_bytes = chunk.end - chunk.begin;
+		chunk.records.reserve(chunk_bytes / 64);
+		chunk.strings.reserve(chunk_bytes);
+
+		const char* p = chunk.begin;
+		const char* const end = chunk.end;
+		uint32_t line_index = 0;
+
+		while (p < end) {
+			const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+			if (eol == nullptr) {
+				eol = end;
+			}
+
+			const char* line_end = eol;
+			if (line_end > p && *(line_end - 1) == '\r') {
+				line_end--;
+			}
+
+			const char* sep = static_cast<const char*>(memchr(p, ';', line_end - p));
+			if (sep != nullptr && sep > p) {
+				GameFileUri::id_t id = 0;
+				const auto res = std::from_chars(p, sep, id);
+				const char* path = sep + 1;
+				size_t length = line_end - path;
+
+				// the few non-ascii paths are lowered the same way as lookups.
+				QByteArray lowered;
+				if (!isAscii(std::string_view(path, length))) {
+					lowered = QString::fromUtf8(path, length).toLower().toUtf8();
+					path = lowered.constData();
+					length = lowered.size();
+				}
+
+				if (res.ec == std::errc{} && res.ptr == sep && length > 0 && length <= UINT16_MAX) {
+					Record record;
+					record.id = id;
+					record.offset = static_cast<uint32_t>(chunk.strings.size());
+					record.line = line_index++;
+
+					const uint16_t length16 = static_cast<uint16_t>(length);
+					chunk.strings.insert(chunk.strings.end(), reinterpret_cast<const uint8_t*>(&length16), reinterpret_cast<const uint8_t*>(&length16) + sizeof(length16));
+					std::transform(path, path + length, std::back_inserter(chunk.strings), [](char c) { return static_cast<uint8_t>(foldCase(c)); });
+
+					record.hash = hashPath(std::string_view(reinterpret_cast<const char*>(chunk.strings.data() + record.offset + sizeof(length16)), length));
+					chunk.records.push_back(record);
+				}
+			}
+
+			p = eol + 1;
+		}
+	}
+
+	bool ListFileIndex::attach(const uint8_t* data, size_t size)
+	{
+		if (data == nullptr || size < sizeof(Header)) {
+			return false;
+		}
+
+		const Header* header = reinterpret_cast<const Header*>(data);
+
+		if (header->magic != MAGIC || header->version != VERSION) {
+			return false;
+		}
+
+		// offsets and counts are read from the file, so are checked without overflowing.
+		auto fits = [size](uint64_t offset, uint64_t count, size_t element_size) {
+			return offset <= size && count <= (size - offset) / element_size;
+		};
+
+		const bool in_bounds =
+			std::has_single_bit(header->hashCapacity) &&
+			header->hashTableOffset % alignof(HashEntry) == 0 &&
+			header->idTableOffset % alignof(IdEntry) == 0 &&
+			fits(header->hashTableOffset, header->hashCapacity, sizeof(HashEntry)) &&
+			fits(header->idTableOffset, header->entryCount, sizeof(IdEntry)) &&
+			fits(header->stringsOffset, header->stringsSize, 1);
+
+		if (!in_bounds) {
+			return false;
+		}
+
+		// every entry is checked once here, so lookups can read the strings without bounds checks.
+		const uint8_t* strings = data + header->stringsOffset;
+		const uint64_t strings_size = header->stringsSize;
+
+		auto valid_string = [strings, strings_size](uint32_t offset) {
+			if (offset > strings_size || strings_size - offset < sizeof(uint16_t)) {
+				return false;
+			}
+
+			uint16_t length;
+			memcpy(&length, strings + offset, sizeof(length));
+			return length <= strings_size - offset - sizeof(uint16_t);
+		};
+
+		const std::span<const IdEntry> ids(reinterpret_cast<const IdEntry*>(data + header->idTableOffset), header->entryCount);
+		for (size_t i = 0; i < ids.size(); i++) {
+			if (!valid_string(ids[i].offset) || (i > 0 && ids[i - 1].id >= ids[i].id)) {
+				return false;
+			}
+		}
+
+		// probing stops at an empty slot, a full table would never terminate.
+		size_t empty_slots = 0;
+		for (const auto& slot : std::span<const HashEntry>(reinterpret_cast<const HashEntry*>(data + header->hashTableOffset), header->hashCapacity)) {
+			if (slot.hash == EMPTY_HASH) {
+				empty_slots++;
+			}
+			else if (!valid_string(slot.offset)) {
+				return false;
+			}
+		}
+
+		if (empty_slots == 0) {
+			return false;
+		}
+
+		_header = header;
+		_data = data;
+		_size = size;
+		return true;
+	}
+
+	bool ListFileIndex::mapFile(const QString& path)
+	{
+		auto file = std::make_unique<QFile>(path);
+		if (!file->open(QIODevice::ReadOnly)) {
+			return false;
+		}
+
+		const auto size = file->size();
+		const uchar* data = size > 0 ? file->map(0, size) : nullptr;
+
+		if (!attach(data, size)) {
+			return false;
+		}
+
+		_mapped = std::move(file);
+		return true;
+	}
+
+};
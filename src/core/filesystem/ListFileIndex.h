@@ -0,0 +1,228 @@
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <QStringView>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "GameFileUri.h"
+
+namespace core {
+
+	/// <summary>
+	/// Compiled form of the community listfile (id;path csv).
+	/// The csv is parsed once into a binary image of a sorted id table, an open addressing path hash table and a single utf-8 string arena, which is then persisted alongside the csv.
+	/// Later sessions map the image directly and lookups read straight from the mapped pages, the image is rebuilt whenever the csv changes.
+	/// </summary>
+	class ListFileIndex {
+	public:
+		ListFileIndex() = default;
+		ListFileIndex(ListFileIndex&&) = default;
+		ListFileIndex& operator=(ListFileIndex&&) = default;
+		virtual ~ListFileIndex() {}
+
+		// open the index for the csv, (re)building it when missing or out of date.
+		static ListFileIndex open(const QString& csv_path);
+
+		// build the index image from csv content, chunks are parsed and sorted concurrently unless 'parallel' is false (used to benchmark the serial parse.)
+		static std::vector<uint8_t> compile(std::span<const uint8_t> csv, uint64_t source_size, int64_t source_modified, bool parallel = true);
+
+		inline static QString indexPath(const QString& csv_path) {
+			return csv_path + ".idx";
+		}
+
+		size_t size() const {
+			return _header != nullptr ? _header->entryCount : 0;
+		}
+
+		// largest file id present, or zero if empty.
+		GameFileUri::id_t maxId() const {
+			const auto table = idTable();
+			return table.empty() ? 0 : table.back().id;
+		}
+
+		std::optional<GameFileUri::id_t> findId(const GameFileUri::path_t& path) const;
+		std::optional<std::string_view> findPath(GameFileUri::id_t id) const;
+
+		// callback(id_t, std::string_view) once for each distinct path, with the id findId() returns for it, in no particular order.
+		// the csv may list a path under several ids (or an id under several paths), the path table was deduplicated when compiled.
+		template<typename fn>
+		void forEach(fn callback) const {
+			for (const auto& entry : hashTable()) {
+				if (entry.hash != EMPTY_HASH) {
+					callback(entry.id, stringAt(entry.offset));
+				}
+			}
+		}
+
+		// paths are stored lowercase, matching is case insensitive.
+		// ascii is folded a byte at a time, paths containing anything else are lowered with QString::toLower as the csv used to be.
+		static constexpr char foldCase(char c) {
+			return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+		}
+
+		static bool isAscii(std::string_view str) {
+			return std::all_of(str.begin(), str.end(), [](char c) { return static_cast<uint8_t>(c) < 0x80; });
+		}
+
+		static bool isAscii(QStringView str) {
+			return std::all_of(str.begin(), str.end(), [](QChar c) { return c.unicode() < 0x80; });
+		}
+
+		// 64-bit FNV-1a over the case folded utf-8 bytes, both overloads produce the same value for the same path.
+		static uint64_t hashPath(std::string_view path);
+		static uint64_t hashPath(QStringView path);
+
+		// invoke callback(uint8_t) for each byte of the case folded utf-8 encoding, only non-ascii paths allocate.
+		template<typename fn>
+		static bool visitFolded(QStringView str, fn callback) {
+			if (isAscii(str)) {
+				return visitUtf8(str, [&callback](uint8_t c) {
+					return callback(static_cast<uint8_t>(foldCase(static_cast<char>(c))));
+				});
+			}
+
+			const QString lowered = str.toString().toLower();
+			return visitUtf8(lowered, callback);
+		}
+
+		// invoke callback(uint8_t) for each byte of the utf-8 encoding, without allocating, stops early if the callback returns false.
+		template<typename fn>
+		static bool visitUtf8(QStringView str, fn callback) {
+			const qsizetype length = str.size();
+			for (qsizetype i = 0; i < length; i++) {
+				const char16_t c = str[i].unicode();
+
+				if (c < 0x80) {
+					if (!callback(static_cast<uint8_t>(c))) return false;
+				}
+				else if (c < 0x800) {
+					if (!callback(static_cast<uint8_t>(0xC0 | (c >> 6)))) return false;
+					if (!callback(static_cast<uint8_t>(0x80 | (c & 0x3F)))) return false;
+				}
+				else if (QChar::isHighSurrogate(c) && (i + 1) < length && QChar::isLowSurrogate(str[i + 1].unicode())) {
+					const char32_t cp = QChar::surrogateToUcs4(c, str[++i].unicode());
+					if (!callback(static_cast<uint8_t>(0xF0 | (cp >> 18)))) return false;
+					if (!callback(static_cast<uint8_t>(0x80 | ((cp >> 12) & 0x3F)))) return false;
+					if (!callback(static_cast<uint8_t>(0x80 | ((cp >> 6) & 0x3F)))) return false;
+					if (!callback(static_cast<uint8_t>(0x80 | (cp & 0x3F)))) return false;
+				}
+				else {
+					if (!callback(static_cast<uint8_t>(0xE0 | (c >> 12)))) return false;
+					if (!callback(static_cast<uint8_t>(0x80 | ((c >> 6) & 0x3F)))) return false;
+					if (!callback(static_cast<uint8_t>(0x80 | (c & 0x3F)))) return false;
+				}
+			}
+
+			return true;
+		}
+
+	protected:
+
+		static constexpr std::array<uint8_t, 4> MAGIC = { 'W', 'L', 'F', 'I' };
+		static constexpr uint32_t VERSION = 3;
+
+		// maximum load factor of the path table is 3/4.
+		static constexpr size_t hashCapacity(size_t count) {
+			return std::bit_ceil(std::max<size_t>(16, count + (count / 3) + 1));
+		}
+
+		// a zero hash marks an empty slot in the path table, real hashes are remapped away from it.
+		static constexpr uint64_t EMPTY_HASH = 0;
+
+		struct Header {
+			std::array<uint8_t, 4> magic;
+			uint32_t version;
+			uint64_t sourceSize;
+			int64_t sourceModified;
+			uint32_t entryCount;
+			uint32_t hashCapacity;
+			uint64_t idTableOffset;
+			uint64_t hashTableOffset;
+			uint64_t stringsOffset;
+			uint64_t stringsSize;
+		};
+
+		// sorted by id.
+		struct IdEntry {
+			uint32_t id;
+			uint32_t offset;
+		};
+
+		// open addressing (linear probe) slot, keyed by path hash.
+		struct HashEntry {
+			uint64_t hash;
+			uint32_t id;
+			uint32_t offset;
+		};
+
+		// intermediate entry, produced while parsing the csv.
+		struct Record {
+			uint64_t hash;
+			uint32_t id;
+			uint32_t offset;
+			uint32_t line;
+		};
+
+		// newline aligned byte range of the csv, parsed independently of the other chunks.
+		struct Chunk {
+			const char* begin;
+			const char* end;
+
+			std::vector<Record> records;
+			std::vector<uint8_t> strings;
+
+			// position of the chunk results within the merged output.
+			size_t recordBase = 0;
+			size_t stringBase = 0;
+		};
+
+		// chunks smaller than this arent worth the overhead of a separate task.
+		static constexpr size_t MIN_CHUNK_BYTES = 1024 * 1024;
+
+		static std::vector<Chunk> splitChunks(std::span<const uint8_t> csv, size_t max_chunks);
+		static void parseChunk(Chunk& chunk);
+
+		bool attach(const uint8_t* data, size_t size);
+		bool mapFile(const QString& path);
+
+		std::span<const IdEntry> idTable() const {
+			if (_header == nullptr) {
+				return {};
+			}
+			return { reinterpret_cast<const IdEntry*>(_data + _header->idTableOffset), _header->entryCount };
+		}
+
+		std::span<const HashEntry> hashTable() const {
+			if (_header == nullptr) {
+				return {};
+			}
+			return { reinterpret_cast<const HashEntry*>(_data + _header->hashTableOffset), _header->hashCapacity };
+		}
+
+		// strings are stored as a uint16_t length followed by the (unterminated) bytes.
+		std::string_view stringAt(uint32_t offset) const {
+			const uint8_t* str = _data + _header->stringsOffset + offset;
+			uint16_t length;
+			memcpy(&length, str, sizeof(length));
+			return { reinterpret_cast<const char*>(str + sizeof(length)), length };
+		}
+
+		const Header* _header = nullptr;
+		const uint8_t* _data = nullptr;
+		size_t _size = 0;
+
+		// backing storage, either a mapped file or an in memory image (used if the index couldnt be persisted.)
+		std::unique_ptr<QFile> _mapped;
+		std::vector<uint8_t> _owned;
+	};
+
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <deque>
+#include <mutex>
 #include <vector>
 #include "GameFileSystem.h"
 #include <WDBReader/Filesystem/MPQFilesystem.hpp>
@@ -9,25 +10,28 @@ namespace core {
 
 	class MPQFile final : public ArchiveFile {
 	public:
-		MPQFile(const GameFileUri& uri, std::unique_ptr<WDBReader::Filesystem::MPQFileSource> source) :
-			_impl(std::move(source)), ArchiveFile(uri)
+		MPQFile(const GameFileUri& uri, std::unique_ptr<WDBReader::Filesystem::MPQFileSource> source, std::mutex* archive_mutex = nullptr) :
+			_impl(std::move(source)), archiveMutex(archive_mutex), ArchiveFile(uri)
 		{}
 
 		uint64_t getFileSize() override;
 		void read(void* dest, uint64_t bytes, uint64_t offset = 0) override;
-		std::unique_ptr<WDBReader::Filesystem::FileSource> release() override {
-			return std::move(_impl);
-		}
+
+		// the returned source is read outside of the archive lock, so the content is copied into memory first.
+		std::unique_ptr<WDBReader::Filesystem::FileSource> release() override;
 
 	protected:
 		std::unique_ptr<WDBReader::Filesystem::MPQFileSource> _impl;
+		std::mutex* archiveMutex;
 	};
 
 	class MPQFileSystem final : public GameFileSystem {
 	public:
 		MPQFileSystem(const QString& root, const QString& locale);
-		MPQFileSystem(MPQFileSystem&&) = default;
-		virtual ~MPQFileSystem() = default;
+		MPQFileSystem(MPQFileSystem&&) = delete;
+		virtual ~MPQFileSystem() {
+			waitForOpens();
+		}
 
 		constexpr QChar seperator() const override {
 			return '\\';
@@ -38,13 +42,16 @@ namespace core {
 		std::unique_ptr<ArchiveFile> openFile(const GameFileUri& uri) override;
 		std::unique_ptr<std::vector<GameFileUri::path_t>> fileList(std::function<bool(const GameFileUri::path_t&)> pred) override;
 
-		GameFileUri asFileId(const GameFileUri& uri) override;
-		GameFileUri asFilePath(const GameFileUri& uri) override;
-		GameFileUri asInternal(const GameFileUri& uri) override;
-		GameFileUri asInternal(const GameFileInfo& info) override;
-		GameFileInfo asInfo(const GameFileUri& uri) override;
+		GameFileUri asFileId(const GameFileUri& uri) const override;
+		GameFileUri asFilePath(const GameFileUri& uri) const override;
+		GameFileUri asInternal(const GameFileUri& uri) const override;
+		GameFileUri asInternal(const GameFileInfo& info) const override;
+		GameFileInfo asInfo(const GameFileUri& uri) const override;
 
 	protected:
 		std::unique_ptr<WDBReader::Filesystem::MPQFilesystem> _impl;
+
+		// stormlib archives share a single file stream and aren't safe for concurrent use, all archive access is serialised.
+		std::mutex archiveMutex;
 	};
 };
\ No newline at end of file
@@ -1,22 +1,39 @@
 #include "../../stdafx.h"
 #include "MPQFileSystem.h"
 
-#include <execution>
 #include <algorithm>
+#include <cctype>
+#include <string_view>
+#include <unordered_set>
 #include <QFile>
 #include <QDir>
+#include <QtConcurrent>
 
 namespace core {
 
 	uint64_t MPQFile::getFileSize() {
+		std::unique_lock lock = archiveMutex != nullptr ? std::unique_lock(*archiveMutex) : std::unique_lock<std::mutex>();
 		return _impl->size();
 	}
 
 	void MPQFile::read(void* dest, uint64_t bytes, uint64_t offset) {
+		std::unique_lock lock = archiveMutex != nullptr ? std::unique_lock(*archiveMutex) : std::unique_lock<std::mutex>();
 		_impl->setPos(offset);
 		_impl->read(dest, bytes);
 	}
 
+	std::unique_ptr<WDBReader::Filesystem::FileSource> MPQFile::release() {
+		if (archiveMutex == nullptr) {
+			return std::move(_impl);
+		}
+
+		std::scoped_lock lock(*archiveMutex);
+		_impl->setPos(0);
+		auto memory_source = std::make_unique<WDBReader::Filesystem::MemoryFileSource>(*_impl);
+		_impl.reset();
+		return memory_source;
+	}
+
 	MPQFileSystem::MPQFileSystem(const QString& root, const QString& locale) :GameFileSystem(root, locale)
 	{
 		auto discovered = WDBReader::Filesystem::discoverMPQArchives(root.toStdString());
@@ -32,9 +49,14 @@ namespace core {
 	std::unique_ptr<ArchiveFile> MPQFileSystem::openFile(const GameFileUri& uri)
 	{
 		if (uri.isPath()) {
-			auto raw = _impl->open(uri.getPath().toStdString());
+			std::unique_ptr<WDBReader::Filesystem::MPQFileSource> raw;
+			{
+				std::scoped_lock lock(archiveMutex);
+				raw = _impl->open(uri.getPath().toStdString());
+			}
+
 			if (raw != nullptr) {
-				return std::make_unique<MPQFile>(uri, std::move(raw));
+				return std::make_unique<MPQFile>(uri, std::move(raw), &archiveMutex);
 			}
 		}
 
@@ -43,59 +65,112 @@ namespace core {
 
 	std::unique_ptr<std::vector<GameFileUri::path_t>> MPQFileSystem::fileList(std::function<bool(const GameFileUri::path_t&)> pred)
 	{
-		auto list_items = std::make_unique<std::vector<QString>>();
+		// mpq names are case insensitive, the same file is commonly listed by several patch archives.
+		struct FoldedHash {
+			size_t operator()(std::string_view str) const {
+				size_t hash = 0xcbf29ce484222325ull;
+				for (const char c : str) {
+					hash ^= static_cast<uint8_t>(std::tolower(static_cast<unsigned char>(c)));
+					hash *= 0x100000001b3ull;
+				}
+				return hash;
+			}
+		};
+
+		struct FoldedEqual {
+			bool operator()(std::string_view a, std::string_view b) const {
+				return std::ranges::equal(a, b, [](char x, char y) {
+					return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+				});
+			}
+		};
+
+		struct ArchiveListing {
+			HANDLE handle;
+			std::vector<uint8_t> buffer;
+			std::vector<std::string_view> names;	// views into buffer.
+		};
 
-		const QString listfile_name = "(listfile)";
+		// held for the whole listing, the per archive reads below are independent of each other but not of other archive users.
+		std::scoped_lock lock(archiveMutex);
+
+		std::vector<ArchiveListing> listings;
+		listings.reserve(_impl->getHandles().size());
 		for (auto& mpq : _impl->getHandles()) {
-			HANDLE temp;
-			if (SFileOpenFileEx(mpq.second, listfile_name.toStdString().c_str(), SFILE_OPEN_FROM_MPQ, &temp)) {
-				auto source = std::make_unique<WDBReader::Filesystem::MPQFileSource>(temp);
-				MPQFile list_file(listfile_name, std::move(source));
+			listings.push_back({ mpq.second });
+		}
 
-				auto list_file_size = list_file.getFileSize();
-				if (list_file_size > 0) {
-					auto list_file_buffer = std::vector<uint8_t>(list_file_size);
-					list_file.read(list_file_buffer.data(), list_file_size);
+		// each archive has its own handle, so the listfiles can be read and split concurrently.
+		QtConcurrent::blockingMap(listings, [](ArchiveListing& listing) {
+			HANDLE temp;
+			if (!SFileOpenFileEx(listing.handle, "(listfile)", SFILE_OPEN_FROM_MPQ, &temp)) {
+				return;
+			}
 
-					uint8_t* p = list_file_buffer.data();
-					uint8_t* end = list_file_buffer.data() + list_file_size;
+			auto source = std::make_unique<WDBReader::Filesystem::MPQFileSource>(temp);
+			MPQFile list_file(QString("(listfile)"), std::move(source));
 
-					while (p < end) {
-						uint8_t* q = p;
-						do {
-							if (*q == '\r' || *q == '\n') // carriage return or new line
-								break;
-						} while (q++ <= end);
+			const auto list_file_size = list_file.getFileSize();
+			if (list_file_size == 0) {
+				return;
+			}
 
-						QString line = QString::fromStdString(std::string((char*)p, q - p));
+			listing.buffer.resize(list_file_size);
+			list_file.read(listing.buffer.data(), list_file_size);
 
-						p = q + 2;
+			const char* p = reinterpret_cast<const char*>(listing.buffer.data());
+			const char* const end = p + listing.buffer.size();
 
-						if (line.length() == 0) {
-							break;
-						}
+			while (p < end) {
+				const char* q = std::find_if(p, end, [](char c) {
+					return c == '\r' || c == '\n' || c == ';';
+				});
 
-						if (pred(line)) {
-							list_items->push_back(line);
-						}
-					}
+				if (q > p) {
+					listing.names.emplace_back(p, q - p);
 				}
+
+				p = q + 1;
+			}
+		});
+
+		std::unordered_set<std::string_view, FoldedHash, FoldedEqual> unique_names;
+		{
+			size_t name_count = 0;
+			for (const auto& listing : listings) {
+				name_count += listing.names.size();
+			}
+			unique_names.reserve(name_count);
+
+			for (const auto& listing : listings) {
+				unique_names.insert(listing.names.begin(), listing.names.end());
 			}
 		}
 
-		auto last = std::unique(list_items->begin(), list_items->end());
-		list_items->erase(last, list_items->end());
+		auto list_items = std::make_unique<std::vector<QString>>();
+
+		for (const auto& name : unique_names) {
+			QString path = QString::fromUtf8(name.data(), name.size());
+			if (pred(path)) {
+				list_items->push_back(std::move(path));
+			}
+		}
+
+		std::sort(list_items->begin(), list_items->end(), [](const QString& a, const QString& b) {
+			return a.compare(b, Qt::CaseInsensitive) < 0;
+		});
+
 		list_items->shrink_to_fit();
 
 		return list_items;
 	}
 
-	GameFileUri MPQFileSystem::asFileId(const GameFileUri& uri)
+	GameFileUri MPQFileSystem::asFileId(const GameFileUri& uri) const
 	{
 		return (GameFileUri::id_t)0;
 	}
 
-	GameFileUri MPQFileSystem::asFilePath(const GameFileUri& uri)
+	GameFileUri MPQFileSystem::asFilePath(const GameFileUri& uri) const
 	{
 		if (uri.isId()) {
 			throw std::bad_variant_access();
@@ -104,17 +179,17 @@ namespace core {
 		return uri;
 	}
 
-	GameFileUri MPQFileSystem::asInternal(const GameFileUri& uri)
+	GameFileUri MPQFileSystem::asInternal(const GameFileUri& uri) const
 	{
 		return asFilePath(uri);
 	}
 
-	GameFileUri MPQFileSystem::asInternal(const GameFileInfo& info)
+	GameFileUri MPQFileSystem::asInternal(const GameFileInfo& info) const
 	{
 		return info.path;
 	}
 
-	GameFileInfo MPQFileSystem::asInfo(const GameFileUri& uri)
+	GameFileInfo MPQFileSystem::asInfo(const GameFileUri& uri) const
 	{
 		if (uri.isId()) {
 			throw std::bad_variant_access();
@@ -427,6 +427,12 @@ namespace core {
 		UNK_0x200000 = 0x200000,
 	};
 
+	// https://wowdev.wiki/M2#Animation_sequences
+	enum ModelAnimationFlags : uint32_t {
+		PRIMARY_BONE_SEQUENCE = 0x20,	// animation data is stored in the model file, otherwise in an external .anim file (wotlk+)
+		ALIAS_SEQUENCE = 0x40,			// sequence has no data, uses the next alias instead.
+	};
+
 	class GenderUtil {
 	public:
 		static inline QString toString(Gender value) {
@@ -2,7 +2,11 @@
 
 #include "../utility/Quaternion.h"
 #include "M2Definitions.h"
+#include "AnimationFiles.h"
 #include "../utility/Memory.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <map>
 #include <span>
@@ -56,7 +60,7 @@ namespace core {
 		std::vector<T> keys;
 
 		template<M2_VER_RANGE R>
-		static RangeBasedAnimationBlock<T> fromDefinition(const AnimationBlockM2<R>& definition, const std::span<uint8_t> buffer, const std::map<size_t, ChunkedFile>& animFiles) {
+		static RangeBasedAnimationBlock<T> fromDefinition(const AnimationBlockM2<R>& definition, const std::span<const uint8_t> buffer, AnimationFiles& animFiles) {
 			RangeBasedAnimationBlock<T> anim_block;
 
 			anim_block.interpolationType = definition.interpolationType;
@@ -92,16 +96,23 @@ namespace core {
 		std::vector<std::vector<uint32_t>> timestamps;
 		std::vector<std::vector<T>> keys;
 
+		// animations stored in external files, these are read on first use rather than during load.
+		std::vector<ExternalAnimationSource> external;
+		AnimationFiles* files = nullptr;
+
 		template<M2_VER_RANGE R>
-		static TimelineBasedAnimationBlock<T> fromDefinition(const AnimationBlockM2<R>& definition, const std::span<uint8_t> buffer, const std::map<size_t, ChunkedFile>& animFiles) {
+		static TimelineBasedAnimationBlock<T> fromDefinition(const AnimationBlockM2<R>& definition, const std::span<const uint8_t> buffer, AnimationFiles& animFiles) {
 			TimelineBasedAnimationBlock<T> anim_block;
 
 			anim_block.interpolationType = definition.interpolationType;
 			anim_block.globalSequence = definition.globalSequence;
+			anim_block.files = &animFiles;
 
 			assert(definition.timestamps.size == definition.keys.size);
 
-			auto load_data = [&](const M2Array& def, auto& dest) {
+			std::map<uint32_t, ExternalAnimationSource> external;
+
+			auto load_data = [&](const M2Array& def, auto& dest, AnimationBlockHeader ExternalAnimationSource::* external_header) {
 				using dest_val_t = std::remove_reference_t<decltype(dest)>::value_type::value_type;
 
 				if (def.size) {
@@ -120,37 +131,18 @@ namespace core {
 							continue;
 						}
 
+						if (animFiles.isExternal(header_index)) {
+							auto& source = external[(uint32_t)header_index];
+							source.animationIndex = (uint32_t)header_index;
+							source.*external_header = header;
+							continue;
+						}
+
 						const auto read_size = sizeof(dest_val_t) * header.size;
 						std::vector<dest_val_t> temp;
 						temp.resize(header.size);
 
-						const auto animFile = animFiles.find(header_index);
-						if (animFile != animFiles.end()) {
-							assert(animFile->second.file);
-							if (animFile->second.isChunked()) {
-
-								const auto afsb = animFile->second.chunks.find(Signatures::AFSB);
-								const auto afm2 = animFile->second.chunks.find(Signatures::AFM2);
-								if (afsb != animFile->second.chunks.end()) {
-									animFile->second.file->read(temp.data(), read_size, afsb->second.offset + header.offset);
-								}
-								else if (afm2 != animFile->second.chunks.end()) {
-									animFile->second.file->read(temp.data(), read_size, afm2->second.offset + header.offset);
-								}
-								else {
-									assert(false);	//shouldnt happen
-									continue;
-								}
-							}
-							else if (animFile->second.file->getFileSize() >= (header.offset + read_size)) {
-								animFile->second.file->read(temp.data(), read_size, header.offset);
-							}
-							else {
-								// should happen, but happens sometimes for cata models.
-								continue;
-							}
-						}
-						else if (buffer.size() >= (header.offset + read_size)) {
+						if (buffer.size() >= (header.offset + read_size)) {
 							memcpy_x(temp, buffer, header.offset, read_size);
 						}
 						else {
@@ -165,8 +157,13 @@ namespace core {
 				assert(dest.size() == def.size);
 			};
 
-			load_data(definition.timestamps, anim_block.timestamps);
-			load_data(definition.keys, anim_block.keys);
+			load_data(definition.timestamps, anim_block.timestamps, &ExternalAnimationSource::timestamps);
+			load_data(definition.keys, anim_block.keys, &ExternalAnimationSource::keys);
+
+			anim_block.external.reserve(external.size());
+			for (const auto& [index, source] : external) {
+				anim_block.external.push_back(source);
+			}
 
 			return anim_block;
 		}
@@ -268,11 +265,130 @@ namespace core {
 
 #define	MAX_ANIMATED	500
 
+	/// <summary>
+	/// Keyframe search for a track, remembering the last key found.
+	/// Playback normally advances a little each frame, so the next lookup usually lands on the same or following key and the binary search can be skipped.
+	/// The cursor is only a hint and is validated before use, so the owning value can still be evaluated concurrently.
+	/// </summary>
+	class KeyframeCursor {
+	public:
+		KeyframeCursor() = default;
+		KeyframeCursor(const KeyframeCursor& other) : last(other.last.load(std::memory_order_relaxed)) {}
+		KeyframeCursor& operator=(const KeyframeCursor& other) {
+			last.store(other.last.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			return *this;
+		}
+
+		// index of the key segment containing time, clamped to [0, times.size() - 2] - times must contain at least 2 keys.
+		size_t find(std::span<const uint32_t> times, uint32_t time) const {
+			assert(times.size() > 1);
+
+			auto contains = [&](size_t i) {
+				return (i + 1) < times.size() && times[i] <= time && time < times[i + 1];
+			};
+
+			const size_t hint = last.load(std::memory_order_relaxed);
+			size_t pos;
+
+			if (contains(hint)) {
+				pos = hint;
+			}
+			else if (contains(hint + 1)) {
+				pos = hint + 1;
+			}
+			else {
+				const auto upper = std::upper_bound(times.begin(), times.end(), time);
+				pos = std::clamp<size_t>(std::distance(times.begin(), upper), 1, times.size() - 1) - 1;
+			}
+
+			last.store(pos, std::memory_order_relaxed);
+			return pos;
+		}
+
+	private:
+		mutable std::atomic<size_t> last{ 0 };
+	};
+
+
+	/// <summary>
+	/// Keys of a timeline track which are stored in external .anim files, each animation is read by AnimationFiles on first use.
+	/// A loaded animation is published once and never modified, so it can be read while other animations are loading.
+	/// </summary>
+	template<typename T>
+	class ExternalAnimationTrack : public IExternalAnimationTrack {
+	public:
+		struct Keys {
+			std::vector<uint32_t> times;
+			std::vector<T> data;
+		};
+
+		// reads the keys described by the header, converting from the file format.
+		using decoder_t = std::function<std::vector<T>(std::span<const uint8_t> buffer, const AnimationBlockHeader& header)>;
+
+		ExternalAnimationTrack(std::vector<ExternalAnimationSource>&& src, size_t animation_count, decoder_t&& decoder) :
+			sources(std::move(src)),
+			animations(animation_count),
+			decode(std::move(decoder))
+		{}
+		ExternalAnimationTrack(ExternalAnimationTrack&&) = delete;
+		virtual ~ExternalAnimationTrack() {
+			for (auto& anim : animations) {
+				delete anim.load(std::memory_order_relaxed);
+			}
+		}
+
+		// keys for the animation, or nullptr if the animation hasnt been loaded (or isnt external.)
+		const Keys* get(size_t animation_index) const {
+			if (animation_index < animations.size()) {
+				return animations[animation_index].load(std::memory_order_acquire);
+			}
+
+			return nullptr;
+		}
+
+		void load(size_t animation_index, std::span<const uint8_t> buffer) override {
+			const auto source = std::lower_bound(sources.begin(), sources.end(), animation_index, [](const ExternalAnimationSource& src, size_t index) {
+				return src.animationIndex < index;
+			});
+
+			if (source == sources.end() || source->animationIndex != animation_index || animation_index >= animations.size()) {
+				return;
+			}
+
+			if (animations[animation_index].load(std::memory_order_relaxed) != nullptr) {
+				return;
+			}
+
+			auto keys = std::make_unique<Keys>();
+			keys->data = decode(buffer, source->keys);
+
+			std::vector<uint32_t> file_times;
+			const auto read_size = sizeof(uint32_t) * source->timestamps.size;
+			if (buffer.size() >= (source->timestamps.offset + read_size)) {
+				file_times.resize(source->timestamps.size);
+				memcpy(file_times.data(), buffer.data() + source->timestamps.offset, read_size);
+			}
+
+			// same padding as the model file tracks, each key needs a timestamp.
+			const size_t time_count = std::min(file_times.size(), keys->data.size());
+			keys->times.assign(file_times.begin(), file_times.begin() + time_count);
+			keys->times.resize(keys->data.size(), time_count > 0 ? file_times[time_count - 1] : 0);
+
+			animations[animation_index].store(keys.release(), std::memory_order_release);
+		}
+
+	protected:
+		std::vector<ExternalAnimationSource> sources;	// sorted by animation index
+		std::vector<std::atomic<const Keys*>> animations;
+		decoder_t decode;
+	};
+
 
 	template<typename T>
-	class TimelineBasedAnimatedValue : public IAnimatedValue<T> {
+	class TimelineBasedAnimatedValue final : public IAnimatedValue<T> {
 	public:
 		TimelineBasedAnimatedValue() = default;
+		TimelineBasedAnimatedValue(const TimelineBasedAnimatedValue&) = default;
 		TimelineBasedAnimatedValue(TimelineBasedAnimatedValue&&) = default;
 		TimelineBasedAnimatedValue& operator=(TimelineBasedAnimatedValue&& other) = default;
 		virtual ~TimelineBasedAnimatedValue() {}
@@ -287,13 +403,7 @@ namespace core {
 				animation_index = 0;
 			}
 
-			auto found = data.find(animation_index);
-			if (found != data.end()) {
-				//ideally map entries are not created with zero entries, however its not guarenteed
-				return found->second.size() > 0;
-			}
-
-			return false;
+			return keys(animation_index).times.size() > 0;
 		}
 
 		T getValue(size_t animation_index, const AnimationTickArgs& tick) const override {
@@ -319,59 +429,56 @@ namespace core {
 				animation_index = 0;
 			}
 
-			const auto data_match = data.find(animation_index);
-			const auto times_match = times.find(animation_index);
+			const auto anim_keys = keys(animation_index);
+			const size_t count = anim_keys.times.size();
 
-			if (data_match != data.end() && times_match != times.end() &&
-				data_match->second.size() > 1 && times_match->second.size() > 1) {
+			if (count > 1) {
+				const size_t first = anim_keys.first;
+				const std::span<const uint32_t> anim_times = anim_keys.times;
+				const T* anim_data = anim_keys.data;
 
 				auto compute = [&](size_t pos, size_t pos2, float r) {
 					switch (interpolationType) {
 					case INTERPOLATION_NONE:
-						return data_match->second[pos];
+						return anim_data[pos];
 					case INTERPOLATION_LINEAR:
-						return interpolate<T>(r, data_match->second[pos], data_match->second[pos2]);
+						return interpolate<T>(r, anim_data[pos], anim_data[pos2]);
 					case INTERPOLATION_HERMITE:
 						// INTERPOLATION_HERMITE is only used in cameras afaik?
-						return interpolateHermite<T>(r, data.at(animation_index)[pos], data.at(animation_index)[pos2], in.at(animation_index)[pos], out.at(animation_index)[pos]);
+						return interpolateHermite<T>(r, anim_data[pos], anim_data[pos2], keyframes->in[first + pos], keyframes->out[first + pos]);
 					case INTERPOLATION_BEZIER:
 						//Is this used ingame or only by custom models?
-						return interpolateBezier<T>(r, data.at(animation_index)[pos], data.at(animation_index)[pos2], in.at(animation_index)[pos], out.at(animation_index)[pos]);
+						return interpolateBezier<T>(r, anim_data[pos], anim_data[pos2], keyframes->in[first + pos], keyframes->out[first + pos]);
 					default:
 						//this shouldn't appear!
-						return data_match->second[pos];
+						return anim_data[pos];
 						
 					}
 				};
 
 				float r = 1.0f;
 				size_t pos = 0;
-				const size_t max_time = times_match->second.back();
+				const size_t max_time = anim_times.back();
 
 				//if (max_time > 0)
 				//	time %= max_time; // I think this might not be necessary?
 				if (time > max_time) {
-					pos = times_match->second.size() - 1;
+					pos = count - 1;
 
 					return compute(pos, pos, r);
 				}
 				else {
-					for (size_t i = 0; i < times_match->second.size() - 1; i++) {
-						if (time >= times_match->second[i] && time < times_match->second[i + 1]) {
-							pos = i;
-							break;
-						}
-					}
-					size_t t1 = times_match->second[pos];
-					size_t t2 = times_match->second[pos + 1];
+					pos = cursor.find(anim_times, time);
+					size_t t1 = anim_times[pos];
+					size_t t2 = anim_times[pos + 1];
 					r = (time - t1) / (float)(t2 - t1);
 
 					return compute(pos, pos + 1, r);
 				}
 
 			}
-			else if(data_match != data.end() && data_match->second.size() > 0) {
-				return data.at(animation_index)[0];
+			else if(count > 0) {
+				return anim_keys.data[0];
 			}
 
 			return T();
@@ -400,78 +507,149 @@ namespace core {
 				return result;
 			}
 
-			for (size_t j = 0; j < block.timestamps.size(); j++) {
-				result.times.emplace(j, std::move(block.timestamps[j]));
+			switch (result.interpolationType) {
+				case INTERPOLATION_NONE:
+				case INTERPOLATION_LINEAR:
+					break;
+				case INTERPOLATION_HERMITE:
+				case INTERPOLATION_BEZIER:
+				{
+					//TODO implement
+					assert(false);
+					throw 1;
+					//for (size_t i = 0; i < pHeadKeys->nEntrys; i++) {
+					//	data[j].push_back(Conv::conv(keys[i * 3]));
+					//	in[j].push_back(Conv::conv(keys[i * 3 + 1]));
+					//	out[j].push_back(Conv::conv(keys[i * 3 + 2]));
+					//}
+				}
+				break;
 			}
 
-			////keys
+			// every animation is packed into a single timestamp and key array, with offsets[i]..offsets[i + 1] holding animation i.
+			size_t total_keys = 0;
+			for (const auto& keys : block.keys) {
+				total_keys += keys.size();
+			}
+
+			auto frames = std::make_shared<Keyframes>();
+			frames->offsets.reserve(block.keys.size() + 1);
+			frames->times.reserve(total_keys);
+			frames->data.reserve(total_keys);
+
+			auto transform = [&fix_fn](auto& val) {
+				return fix_fn(Conv::conv(val));
+			};
+
 			for (size_t j = 0; j < block.keys.size(); j++) {
+				const auto& anim_times = block.timestamps[j];
+				const auto& anim_keys = block.keys[j];
 
-				switch (result.interpolationType) {
-					case INTERPOLATION_NONE:
-					case INTERPOLATION_LINEAR:
-					{
-						auto transform = [&fix_fn](auto& val) {
-							return fix_fn(Conv::conv(val));
-						};
-
-						if constexpr (std::is_same_v<T, D>) {
-							std::transform(block.keys[j].begin(), block.keys[j].end(), block.keys[j].begin(), transform);
-							result.data.emplace(j, std::move(block.keys[j]));
-						}
-						else {
-							std::vector<T> temp;
-							temp.reserve(block.keys[j].size());
-							std::transform(block.keys[j].begin(), block.keys[j].end(), std::back_inserter(temp), transform);
-							result.data.emplace(j, std::move(temp));
-						}
+				frames->offsets.push_back(static_cast<uint32_t>(frames->data.size()));
+
+				std::transform(anim_keys.begin(), anim_keys.end(), std::back_inserter(frames->data), transform);
+
+				// each key needs a timestamp, files should always have matching counts but pad/trim in case they dont.
+				const size_t time_count = std::min(anim_times.size(), anim_keys.size());
+				frames->times.insert(frames->times.end(), anim_times.begin(), anim_times.begin() + time_count);
+				const uint32_t pad_time = time_count > 0 ? anim_times[time_count - 1] : 0;
+				frames->times.resize(frames->data.size(), pad_time);
+			}
+
+			frames->offsets.push_back(static_cast<uint32_t>(frames->data.size()));
+
+			assert(frames->offsets.size() <= (MAX_ANIMATED + 1));
+
+			result.keyframes = std::move(frames);
 
+			if (block.files != nullptr && block.external.size()) {
+				auto decoder = [fix_fn](std::span<const uint8_t> buffer, const AnimationBlockHeader& header) -> std::vector<T> {
+					std::vector<T> keys;
+					const auto read_size = sizeof(D) * header.size;
+
+					if (header.size == 0 || buffer.size() < (header.offset + read_size)) {
+						// should happen, but happens sometimes for cata models.
+						return keys;
 					}
-					break;
-					case INTERPOLATION_HERMITE:
-					case INTERPOLATION_BEZIER:
-					{
-						//TODO implement
-						assert(false);
-						throw 1;
-						//for (size_t i = 0; i < pHeadKeys->nEntrys; i++) {
-						//	data[j].push_back(Conv::conv(keys[i * 3]));
-						//	in[j].push_back(Conv::conv(keys[i * 3 + 1]));
-						//	out[j].push_back(Conv::conv(keys[i * 3 + 2]));
-						//}
+
+					std::vector<D> raw(header.size);
+					memcpy(raw.data(), buffer.data() + header.offset, read_size);
+
+					keys.reserve(raw.size());
+					for (const auto& val : raw) {
+						keys.push_back(fix_fn(Conv::conv(val)));
 					}
-					break;
-				}
-			}
-		
 
-			if (result.times.size() > 0) {
-				assert(result.times.rbegin()->first <= (MAX_ANIMATED - 1));
-			}
-			if (result.data.size() > 0) {
-				assert(result.data.rbegin()->first <= (MAX_ANIMATED - 1));
+					return keys;
+				};
+
+				auto track = std::make_shared<ExternalAnimationTrack<T>>(std::move(block.external), block.keys.size(), std::move(decoder));
+				block.files->registerTrack(track);
+				result.external = std::move(track);
 			}
 
 			return result;
 		}
 
 	protected:
+
+		struct AnimationKeys {
+			std::span<const uint32_t> times;
+			const T* data = nullptr;
+			size_t first = 0;	// position within the model file keys, used for in/out.
+		};
+
+		// keys of the animation, from either the model file or an already loaded external file.
+		AnimationKeys keys(size_t animation_index) const {
+			if (keyframes && animation_index + 1 < keyframes->offsets.size()) {
+				const auto& offsets = keyframes->offsets;
+				const auto& times = keyframes->times;
+				const auto& data = keyframes->data;
+
+				const size_t first = offsets[animation_index];
+				const size_t count = offsets[animation_index + 1] - first;
+				if (count > 0) {
+					return { std::span<const uint32_t>(times.data() + first, count), data.data() + first, first };
+				}
+			}
+
+			if (external) {
+				const auto* loaded = external->get(animation_index);
+				if (loaded != nullptr && loaded->data.size()) {
+					return { loaded->times, loaded->data.data(), 0 };
+				}
+			}
+
+			return {};
+		}
+
 		int32_t interpolationType;
 		int32_t globalSequence;
 		std::shared_ptr<std::vector<uint32_t>> globals;
 
-		std::map<size_t, std::vector<uint32_t>> times;
-		std::map<size_t, std::vector<T>> data;
+		// keys are never modified after loading, copies of the value share them.
+		struct Keyframes {
+			std::vector<uint32_t> offsets;	// indexed by animation, size is animation count + 1.
+			std::vector<uint32_t> times;
+			std::vector<T> data;
+
+			// for nonlinear interpolations:
+			std::vector<T> in;
+			std::vector<T> out;
+		};
 
-		// for nonlinear interpolations:
-		std::map<size_t, std::vector<T>> in;
-		std::map<size_t, std::vector<T>> out;
+		std::shared_ptr<const Keyframes> keyframes;
+
+		std::shared_ptr<const ExternalAnimationTrack<T>> external;
+
+		KeyframeCursor cursor;
 	};
 
 	template<typename T>
-	class RangeBasedAnimatedValue : public IAnimatedValue<T> {
+	class RangeBasedAnimatedValue final : public IAnimatedValue<T> {
 	public:
 		RangeBasedAnimatedValue() = default;
+		RangeBasedAnimatedValue(const RangeBasedAnimatedValue&) = default;
 		RangeBasedAnimatedValue(RangeBasedAnimatedValue&&) = default;
 		RangeBasedAnimatedValue& operator=(RangeBasedAnimatedValue&& other) = default;
 		virtual ~RangeBasedAnimatedValue() {}
@@ -486,7 +664,7 @@ namespace core {
 				animation_index = 0;
 			}
 
-			return ranges.size() > animation_index;
+			return keyframes && keyframes->ranges.size() > animation_index;
 		}
 
 		T getValue(size_t animation_index, const AnimationTickArgs& tick) const override {
@@ -510,9 +688,11 @@ namespace core {
 				animation_index = 0;
 			}
 
-			if (ranges.size() > animation_index) {
+			if (keyframes && keyframes->ranges.size() > animation_index) {
+				const auto& timestamps = keyframes->timestamps;
+				const auto& data = keyframes->data;
 
-				const auto& range = ranges.at(animation_index);
+				const auto& range = keyframes->ranges.at(animation_index);
 				float r = 1.0f;
 				const size_t max_time = timestamps[range.end];
 				const size_t start_time = timestamps[range.start];
@@ -529,11 +709,20 @@ namespace core {
 					return data[pos]; //interpolate<T>(r, data[pos], data[pos]);
 				}
 				else {
-					//TODO can this be limited t range.start and range.end?
-					for (size_t i = 0; i < timestamps.size() - 1; i++) {
-						if (time >= timestamps[i] && time < timestamps[i + 1]) {
-							pos = i;
-							break;
+					// only the keys of the animation's own range need to be searched.
+					pos = range.start;
+					if (range.end > range.start) {
+						const std::span<const uint32_t> range_times(timestamps.data() + range.start, range.end - range.start + 1);
+						pos += cursor.find(range_times, time);
+					}
+
+					// a time on timestamps[range.end] belongs to the segment after the range, as it did when every key was scanned.
+					if (pos + 1 >= timestamps.size() || time >= timestamps[pos + 1]) {
+						pos = std::distance(timestamps.begin(), std::upper_bound(timestamps.begin() + pos, timestamps.end(), time)) - 1;
+
+						// the final key of the track has no segment, the old scan fell back to key 0 here.
+						if (pos + 1 >= timestamps.size()) {
+							return data[pos];
 						}
 					}
 
@@ -584,8 +773,9 @@ namespace core {
 				return result;
 			}
 
-			result.ranges = std::move(block.ranges);
-			result.timestamps = std::move(block.timestamps);
+			auto frames = std::make_shared<Keyframes>();
+			frames->ranges = std::move(block.ranges);
+			frames->timestamps = std::move(block.timestamps);
 
 			switch(result.interpolationType) {
 				case INTERPOLATION_NONE:
@@ -597,11 +787,11 @@ namespace core {
 
 					if constexpr (std::is_same_v<T, D>) {
 						std::transform(block.keys.begin(), block.keys.end(), block.keys.begin(), transform);
-						result.data = std::move(block.keys);
+						frames->data = std::move(block.keys);
 					}
 					else {
-						result.data.reserve(block.keys.size());
-						std::transform(block.keys.begin(), block.keys.end(), std::back_inserter(result.data), transform);
+						frames->data.reserve(block.keys.size());
+						std::transform(block.keys.begin(), block.keys.end(), std::back_inserter(frames->data), transform);
 					}
 				}
 				break;
@@ -620,6 +810,8 @@ namespace core {
 				break;
 			}
 
+			result.keyframes = std::move(frames);
+
 			return result;
 		}
 
@@ -628,9 +820,16 @@ namespace core {
 		int32_t globalSequence;
 		std::shared_ptr<std::vector<uint32_t>> globals;
 
-		std::vector<AnimationRange> ranges;
-		std::vector<uint32_t> timestamps;
-		std::vector<T> data;
+		// shared between copies, never modified once made.
+		struct Keyframes {
+			std::vector<AnimationRange> ranges;
+			std::vector<uint32_t> timestamps;
+			std::vector<T> data;
+		};
+
+		std::shared_ptr<const Keyframes> keyframes;
+
+		KeyframeCursor cursor;
 	};
 
 	template<class T, M2_VER_RANGE R>
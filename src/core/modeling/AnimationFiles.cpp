@@ -0,0 +1,114 @@
+#include "../../stdafx.h"
+#include "AnimationFiles.h"
+#include "../utility/Logger.h"
+
+namespace core {
+
+	AnimationFiles::AnimationFiles(GameFileSystem* fs, bool chunked) :
+		gameFS(fs), chunked(chunked)
+	{
+	}
+
+	void AnimationFiles::add(size_t animation_index, const GameFileUri& uri) {
+		std::scoped_lock lock(mutex);
+		files[animation_index].uri = uri;
+	}
+
+	void AnimationFiles::registerTrack(std::shared_ptr<IExternalAnimationTrack> track) {
+		std::scoped_lock lock(mutex);
+		tracks.push_back(std::move(track));
+	}
+
+	void AnimationFiles::load(size_t animation_index) {
+		auto entry = files.find(animation_index);
+		if (entry == files.end() || entry->second.loaded.load(std::memory_order_acquire)) {
+			return;
+		}
+
+		std::scoped_lock lock(mutex);
+
+		if (entry->second.loaded.load(std::memory_order_relaxed)) {
+			return;
+		}
+
+		std::unique_ptr<ArchiveFile> file;
+
+		try {
+			if (entry->second.pending.valid()) {
+				file = entry->second.pending.get();
+			}
+			else if (gameFS != nullptr) {
+				file = gameFS->openFile(entry->second.uri);
+			}
+		}
+		catch (const std::exception& e) {
+			Log::message("Unable to open animation file: " + entry->second.uri.toString() + " - " + e.what());
+		}
+
+		if (file != nullptr) {
+			ChunkedFile anim_file(std::move(file), chunked);
+			auto buffer = anim_file.file->data();
+			bool valid = true;
+
+			if (anim_file.isChunked()) {
+				const auto afsb = anim_file.chunks.find(Signatures::AFSB);
+				const auto afm2 = anim_file.chunks.find(Signatures::AFM2);
+				if (afsb != anim_file.chunks.end()) {
+					buffer = buffer.subspan(std::min(afsb->second.offset, buffer.size()));
+				}
+				else if (afm2 != anim_file.chunks.end()) {
+					buffer = buffer.subspan(std::min(afm2->second.offset, buffer.size()));
+				}
+				else {
+					assert(false);	//shouldnt happen
+					valid = false;
+				}
+			}
+
+			if (valid) {
+				for (auto& track : tracks) {
+					track->load(animation_index, buffer);
+				}
+			}
+		}
+
+		entry->second.loaded.store(true, std::memory_order_release);
+	}
+
+	void AnimationFiles::prefetch(size_t animation_index) {
+		auto entry = files.find(animation_index);
+		if (entry == files.end() || entry->second.loaded.load(std::memory_order_acquire)) {
+			return;
+		}
+
+		std::scoped_lock lock(mutex);
+
+		if (gameFS == nullptr || entry->second.loaded.load(std::memory_order_relaxed) || entry->second.pending.valid()) {
+			return;
+		}
+
+		entry->second.pending = std::async(std::launch::async, [fs = gameFS, uri = entry->second.uri]() -> std::unique_ptr<ArchiveFile> {
+			auto file = fs->openFile(uri);
+			if (file != nullptr) {
+				file->data();
+			}
+			return file;
+		});
+	}
+
+	void AnimationFiles::detach() {
+		std::scoped_lock lock(mutex);
+
+		for (auto& [index, entry] : files) {
+			if (entry.pending.valid()) {
+				// the prefetched file may still reference the file system, so it is discarded rather than kept for a later load.
+				try {
+					entry.pending.get();
+				}
+				catch (const std::exception&) {}
+			}
+		}
+
+		gameFS = nullptr;
+	}
+};
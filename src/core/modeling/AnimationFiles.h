@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+#include "M2Definitions.h"
+#include "../filesystem/GameFileSystem.h"
+
+namespace core {
+
+	// location of a tracks data for a single animation, within that animations .anim file.
+	struct ExternalAnimationSource {
+		uint32_t animationIndex;
+		AnimationBlockHeader timestamps;
+		AnimationBlockHeader keys;
+	};
+
+	class IExternalAnimationTrack {
+	public:
+		virtual ~IExternalAnimationTrack() {}
+
+		// read the tracks data for the animation, buffer starts at the animation data within the .anim file.
+		virtual void load(size_t animation_index, std::span<const uint8_t> buffer) = 0;
+	};
+
+	/// <summary>
+	/// External .anim files belonging to a model.
+	/// Tracks only record where their data lives while the model loads, an animations file is then read the first time the animation is used.
+	/// Loading is thread safe and may happen while other animations are being evaluated.
+	/// </summary>
+	class AnimationFiles {
+	public:
+		AnimationFiles(GameFileSystem* fs, bool chunked);
+		AnimationFiles(AnimationFiles&&) = delete;
+		virtual ~AnimationFiles() {}
+
+		// should only be called while the model is loading.
+		void add(size_t animation_index, const GameFileUri& uri);
+
+		bool isExternal(size_t animation_index) const {
+			return files.contains(animation_index);
+		}
+
+		void registerTrack(std::shared_ptr<IExternalAnimationTrack> track);
+
+		// read the animation data of every track, blocking until complete, no-op if already loaded.
+		void load(size_t animation_index);
+
+		// start reading the animation file in the background, so a later load doesnt need to wait for the file system.
+		void prefetch(size_t animation_index);
+
+		// stop using the file system, waiting for any prefetch still reading from it. must be called before the file system is destroyed.
+		// animations which were not loaded are left without keys, as if their file was missing.
+		void detach();
+
+		bool isLoaded(size_t animation_index) const {
+			const auto it = files.find(animation_index);
+			return it == files.end() || it->second.loaded.load(std::memory_order_acquire);
+		}
+
+	protected:
+		struct Entry {
+			GameFileUri uri;
+			std::future<std::unique_ptr<ArchiveFile>> pending;
+			std::atomic<bool> loaded{ false };
+		};
+
+		GameFileSystem* gameFS;	// null once detached.
+		const bool chunked;
+
+		std::mutex mutex;
+		std::map<size_t, Entry> files;
+		std::vector<std::shared_ptr<IExternalAnimationTrack>> tracks;
+	};
+};
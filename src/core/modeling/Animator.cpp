@@ -1,5 +1,6 @@
 #include "../../stdafx.h"
 #include "Animator.h"
+#include <atomic>
 
 namespace core {
 
@@ -8,6 +9,7 @@ namespace core {
 		paused = false;
 		totalFrames = 0;
 		speed = 1.0f;
+		invalidate();
 	}
 
 	void Animator::setAnimation(const ModelAnimationSequenceAdaptor* animation, size_t animation_index)
@@ -15,6 +17,7 @@ namespace core {
 		totalFrames = animation->getDuration();
 		animationId = animation->getId();
 		animationIndex = animation_index;
+		invalidate();
 	}
 
 	const AnimationTickArgs& Animator::tick(uint32_t delta_time_msecs)
@@ -28,6 +31,10 @@ namespace core {
 			if (lastTick.currentFrame > frameMax) {
 				lastTick.currentFrame -= frameMax;
 			}
+
+			if (lastTick.deltaTime != 0) {
+				invalidate();
+			}
 		}
 		else {
 			lastTick.deltaTime = 0;
@@ -49,6 +56,7 @@ namespace core {
 	void Animator::setFrame(uint32_t frame)
 	{
 		lastTick.currentFrame = frame;
+		invalidate();
 	}
 
 	const AnimationTickArgs& Animator::getLastTick() const
@@ -81,4 +89,15 @@ namespace core {
 	{
 		return paused;
 	}
+
+	uint64_t Animator::getRevision() const
+	{
+		return revision;
+	}
+
+	void Animator::invalidate()
+	{
+		static std::atomic<uint64_t> next_revision = 0;
+		revision = ++next_revision;
+	}
 }
\ No newline at end of file
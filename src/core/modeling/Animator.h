@@ -30,7 +30,12 @@ namespace core {
 		void setPaused(bool p);
 		bool isPaused() const;
 
+		// changes whenever the pose produced by the animator may have changed, unique across all animators.
+		uint64_t getRevision() const;
+
 	protected:
+		void invalidate();
+
 		bool paused;
 
 		uint32_t totalFrames;
@@ -40,6 +45,8 @@ namespace core {
 		float speed;
 
 		AnimationTickArgs lastTick;
+
+		uint64_t revision;
 	};
 
 };
\ No newline at end of file
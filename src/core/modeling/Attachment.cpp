@@ -27,6 +27,10 @@ namespace core {
 	void Attachment::update(const Animator& animator, const AnimationTickArgs& tick) {
 
 		visit<AttachOwnedModel>([&](AttachOwnedModel* owned) {
+			if (!owned->updatePoseRevision(animator)) {
+				return;
+			}
+
 			owned->model->calculateBones(animator.getAnimationIndex().value(), tick);
 			owned->updateAnimation();
 
@@ -30,6 +30,9 @@ namespace core {
 			virtual ~Effect() {};
 
 			void update(const Animator& animator, const AnimationTickArgs& tick) {
+				if (!updatePoseRevision(animator)) {
+					return;
+				}
 
 				model->calculateBones(animator.getAnimationIndex().value(), tick);
 				updateAnimation();
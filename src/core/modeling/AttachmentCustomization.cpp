@@ -94,6 +94,11 @@ namespace core {
 		return std::move(att);
 	}
 
+	std::future<void> StandardAttachmentCustomizationProvider::prefetch(std::span<const GameFileUri> files) const
+	{
+		return gameFS->prefetch(files);
+	}
+
 	StackVector<AttachmentPosition, 2> MergedAwareAttachmentCustomizationProvider::getAttachmentPositions(CharacterSlot slot, const ItemRecordAdaptor* item, bool sheatheWeapons) const
 	{
 		auto attach_positions = StandardAttachmentCustomizationProvider::getAttachmentPositions(slot, item, sheatheWeapons);
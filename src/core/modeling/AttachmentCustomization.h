@@ -1,5 +1,7 @@
 #pragma once
 #include "Attachment.h"
+#include <future>
+#include <span>
 #include <vector>
 #include "../utility/Memory.h"
 
@@ -27,6 +29,11 @@ namespace core {
 			Model* parent,
 			Scene* scene
 		) const = 0;
+
+		// hint that the files will be needed by upcoming makeAttachment calls.
+		virtual std::future<void> prefetch(std::span<const GameFileUri> files) const {
+			return std::future<void>();
+		}
 	};
 
 	class StandardAttachmentCustomizationProvider : public AttachmentCustomizationProvider {
@@ -50,6 +57,8 @@ namespace core {
 			Scene* scene
 		) const override;
 
+		virtual std::future<void> prefetch(std::span<const GameFileUri> files) const override;
+
 	protected:
 		GameFileSystem* gameFS;
 		GameDatabase* gameDB;
@@ -0,0 +1,589 @@
+#include "../../stdafx.h"
+#include "BlockDecoder.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define WMVX_BLOCKS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define WMVX_BLOCKS_X86 0
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define WMVX_BLOCKS_NEON 1
+#include <arm_neon.h>
+#else
+#define WMVX_BLOCKS_NEON 0
+#endif
+
+// msvc allows intrinsics in any function, gcc / clang need the target enabled per function.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define WMVX_TARGET_SSE41
+#define WMVX_TARGET_AVX2
+#else
+#define WMVX_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define WMVX_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace core {
+
+	namespace {
+
+		using Format = BlockDecoder::Format;
+		// decodes block rows [row_begin, row_end) of the image.
+		using KernelFn = void(*)(const uint8_t*, uint32_t, uint32_t, uint32_t, uint32_t, uint8_t*);
+		using KernelTable = std::array<KernelFn, 3>;
+
+		constexpr uint32_t packColor(uint32_t r, uint32_t g, uint32_t b, uint32_t a) {
+			return r | (g << 8) | (b << 16) | (a << 24);
+		}
+
+		inline uint16_t readU16(const uint8_t* ptr) {
+			return (uint16_t)(ptr[0] | (ptr[1] << 8));
+		}
+
+		// same expansion as ddslib, green is widened with (g << 2) | (g >> 3).
+		inline void expand565(uint16_t color, uint32_t& r, uint32_t& g, uint32_t& b) {
+			const uint32_t r5 = color >> 11;
+			const uint32_t g6 = (color >> 5) & 0x3F;
+			const uint32_t b5 = color & 0x1F;
+
+			r = (r5 << 3) | (r5 >> 2);
+			g = (g6 << 2) | (g6 >> 3);
+			b = (b5 << 3) | (b5 >> 2);
+		}
+
+		// ddslib uses the 3 colour mode for every format, not only BC1.
+		inline void colorPalette(const uint8_t* block, uint32_t palette[4]) {
+			const uint16_t c0 = readU16(block);
+			const uint16_t c1 = readU16(block + 2);
+
+			uint32_t r0, g0, b0, r1, g1, b1;
+			expand565(c0, r0, g0, b0);
+			expand565(c1, r1, g1, b1);
+
+			palette[0] = packColor(r0, g0, b0, 0xFF);
+			palette[1] = packColor(r1, g1, b1, 0xFF);
+
+			if (c0 > c1) {
+				palette[2] = packColor((2 * r0 + r1) / 3, (2 * g0 + g1) / 3, (2 * b0 + b1) / 3, 0xFF);
+				palette[3] = packColor((r0 + 2 * r1) / 3, (g0 + 2 * g1) / 3, (b0 + 2 * b1) / 3, 0xFF);
+			}
+			else {
+				palette[2] = packColor((r0 + r1) / 2, (g0 + g1) / 2, (b0 + b1) / 2, 0xFF);
+				palette[3] = packColor(0x00, 0xFF, 0xFF, 0x00);
+			}
+		}
+
+		inline void alphaPalette(const uint8_t* block, uint8_t palette[8]) {
+			const uint32_t a0 = block[0];
+			const uint32_t a1 = block[1];
+
+			palette[0] = (uint8_t)a0;
+			palette[1] = (uint8_t)a1;
+
+			if (a0 > a1) {
+				for (uint32_t i = 1; i < 7; i++) {
+					palette[i + 1] = (uint8_t)(((7 - i) * a0 + i * a1) / 7);
+				}
+			}
+			else {
+				for (uint32_t i = 1; i < 5; i++) {
+					palette[i + 1] = (uint8_t)(((5 - i) * a0 + i * a1) / 5);
+				}
+				palette[6] = 0;
+				palette[7] = 255;
+			}
+		}
+
+		// 16 x 3 bit indices, little endian.
+		inline uint64_t alphaIndices(const uint8_t* block) {
+			uint64_t bits = 0;
+			for (uint32_t i = 0; i < 6; i++) {
+				bits |= (uint64_t)block[2 + i] << (8 * i);
+			}
+			return bits;
+		}
+
+		template<Format F>
+		inline const uint8_t* colorBlock(const uint8_t* block) {
+			return F == Format::BC1 ? block : block + 8;
+		}
+
+		template<Format F>
+		void decodeBlockScalar(const uint8_t* block, uint32_t pixels[16]) {
+			const uint8_t* color_block = colorBlock<F>(block);
+
+			uint32_t palette[4];
+			colorPalette(color_block, palette);
+
+			for (uint32_t p = 0; p < 16; p++) {
+				pixels[p] = palette[(color_block[4 + p / 4] >> ((p % 4) * 2)) & 0x3];
+			}
+
+			if constexpr (F == Format::BC2) {
+				for (uint32_t p = 0; p < 16; p++) {
+					const uint32_t alpha = (block[p / 2] >> ((p & 1) * 4)) & 0xF;
+					pixels[p] = (pixels[p] & 0x00FFFFFF) | ((alpha * 0x11) << 24);
+				}
+			}
+			else if constexpr (F == Format::BC3) {
+				uint8_t alphas[8];
+				alphaPalette(block, alphas);
+				const uint64_t bits = alphaIndices(block);
+
+				for (uint32_t p = 0; p < 16; p++) {
+					pixels[p] = (pixels[p] & 0x00FFFFFF) | ((uint32_t)alphas[(bits >> (3 * p)) & 0x7] << 24);
+				}
+			}
+		}
+
+		// copies a decoded block to the image, clipped to the image bounds.
+		inline void storeBlock(const uint32_t pixels[16], uint32_t block_x, uint32_t block_y, uint32_t width, uint32_t height, uint8_t* dest) {
+			const uint32_t x = block_x * 4;
+			const uint32_t y = block_y * 4;
+			const uint32_t columns = std::min(4u, width - x);
+			const uint32_t rows = std::min(4u, height - y);
+
+			for (uint32_t r = 0; r < rows; r++) {
+				memcpy(dest + ((size_t)(y + r) * width + x) * 4, pixels + r * 4, columns * 4);
+			}
+		}
+
+		template<Format F>
+		inline void decodeEdgeBlock(const uint8_t* block, uint32_t block_x, uint32_t block_y, uint32_t width, uint32_t height, uint8_t* dest) {
+			uint32_t pixels[16];
+			decodeBlockScalar<F>(block, pixels);
+			storeBlock(pixels, block_x, block_y, width, height, dest);
+		}
+
+		template<Format F>
+		void decodeScalar(const uint8_t* src, uint32_t width, uint32_t height, uint32_t row_begin, uint32_t row_end, uint8_t* dest) {
+			const uint32_t blocks_x = BlockDecoder::blockCount(width);
+
+			for (uint32_t by = row_begin; by < row_end; by++) {
+				const uint8_t* block = src + (size_t)by * blocks_x * BlockDecoder::blockSize(F);
+				for (uint32_t bx = 0; bx < blocks_x; bx++, block += BlockDecoder::blockSize(F)) {
+					decodeEdgeBlock<F>(block, bx, by, width, height, dest);
+				}
+			}
+		}
+
+		constexpr KernelTable scalarKernels = { &decodeScalar<Format::BC1>, &decodeScalar<Format::BC2>, &decodeScalar<Format::BC3> };
+
+#if WMVX_BLOCKS_X86 || WMVX_BLOCKS_NEON
+
+		// byte shuffles selecting a palette entry for each pixel of a row, indexed by the row's 2 bit indices.
+		struct alignas(16) ShuffleMask {
+			uint8_t bytes[16];
+		};
+
+		constexpr std::array<ShuffleMask, 256> makeColorShuffles() {
+			std::array<ShuffleMask, 256> masks{};
+			for (uint32_t indices = 0; indices < 256; indices++) {
+				for (uint32_t n = 0; n < 4; n++) {
+					const uint32_t entry = (indices >> (n * 2)) & 0x3;
+					for (uint32_t k = 0; k < 4; k++) {
+						masks[indices].bytes[n * 4 + k] = (uint8_t)(entry * 4 + k);
+					}
+				}
+			}
+			return masks;
+		}
+
+		// moves the 4 alpha bytes of a row (from the 16 block alphas) into the alpha channel, other bytes are zeroed.
+		constexpr std::array<ShuffleMask, 4> makeAlphaShuffles() {
+			std::array<ShuffleMask, 4> masks{};
+			for (uint32_t r = 0; r < 4; r++) {
+				for (uint32_t i = 0; i < 16; i++) {
+					masks[r].bytes[i] = (i % 4) == 3 ? (uint8_t)(r * 4 + i / 4) : 0x80;
+				}
+			}
+			return masks;
+		}
+
+		// gathers the 2 bytes holding each pixel's 3 bit alpha index into a 16 bit lane, pixels 0 - 7 then 8 - 15.
+		constexpr std::array<ShuffleMask, 2> makeAlphaIndexShuffles() {
+			std::array<ShuffleMask, 2> masks{};
+			for (uint32_t p = 0; p < 16; p++) {
+				const uint32_t byte = 2 + (p * 3) / 8;
+				masks[p / 8].bytes[(p % 8) * 2] = (uint8_t)byte;
+				masks[p / 8].bytes[(p % 8) * 2 + 1] = (uint8_t)(byte + 1);
+			}
+			return masks;
+		}
+
+		// position of the index within its 16 bit lane.
+		constexpr uint32_t alphaIndexShift(uint32_t pixel) {
+			return (pixel * 3) % 8;
+		}
+
+		constexpr std::array<ShuffleMask, 256> colorShuffles = makeColorShuffles();
+		constexpr std::array<ShuffleMask, 4> alphaShuffles = makeAlphaShuffles();
+		constexpr std::array<ShuffleMask, 2> alphaIndexShuffles = makeAlphaIndexShuffles();
+
+#endif
+
+#if WMVX_BLOCKS_X86
+
+		// multiplying by 2^(13 - shift) moves each index to the top 3 bits of its lane, in place of a per lane shift.
+		constexpr std::array<uint16_t, 8> makeAlphaIndexMultipliers(uint32_t first_pixel) {
+			std::array<uint16_t, 8> multipliers{};
+			for (uint32_t i = 0; i < 8; i++) {
+				multipliers[i] = (uint16_t)(1 << (13 - alphaIndexShift(first_pixel + i)));
+			}
+			return multipliers;
+		}
+
+		alignas(16) constexpr std::array<uint16_t, 8> alphaIndexMultipliersLow = makeAlphaIndexMultipliers(0);
+		alignas(16) constexpr std::array<uint16_t, 8> alphaIndexMultipliersHigh = makeAlphaIndexMultipliers(8);
+
+		// the 16 alpha indices of a BC3 block, one per byte.
+		WMVX_TARGET_SSE41 inline __m128i alphaIndicesSSE41(const uint8_t* block) {
+			const __m128i raw = _mm_loadl_epi64((const __m128i*)block);
+
+			const __m128i low = _mm_mullo_epi16(
+				_mm_shuffle_epi8(raw, _mm_load_si128((const __m128i*)alphaIndexShuffles[0].bytes)),
+				_mm_load_si128((const __m128i*)alphaIndexMultipliersLow.data())
+			);
+			const __m128i high = _mm_mullo_epi16(
+				_mm_shuffle_epi8(raw, _mm_load_si128((const __m128i*)alphaIndexShuffles[1].bytes)),
+				_mm_load_si128((const __m128i*)alphaIndexMultipliersHigh.data())
+			);
+
+			return _mm_packus_epi16(_mm_srli_epi16(low, 13), _mm_srli_epi16(high, 13));
+		}
+
+		template<Format F>
+		WMVX_TARGET_SSE41 inline __m128i colorPaletteSSE41(const uint8_t* block) {
+			alignas(16) uint32_t palette[4];
+			colorPalette(colorBlock<F>(block), palette);
+			return _mm_load_si128((const __m128i*)palette);
+		}
+
+		// alpha of all 16 pixels, BC2 / BC3 only.
+		template<Format F>
+		WMVX_TARGET_SSE41 inline __m128i blockAlphasSSE41(const uint8_t* block) {
+			if constexpr (F == Format::BC2) {
+				const __m128i raw = _mm_loadl_epi64((const __m128i*)block);
+				const __m128i low_nibble = _mm_set1_epi8(0x0F);
+				const __m128i nibbles = _mm_unpacklo_epi8(_mm_and_si128(raw, low_nibble), _mm_and_si128(_mm_srli_epi16(raw, 4), low_nibble));
+				return _mm_or_si128(nibbles, _mm_slli_epi16(nibbles, 4));
+			}
+			else {
+				alignas(16) uint8_t palette[16] = {};
+				alphaPalette(block, palette);
+				return _mm_shuffle_epi8(_mm_load_si128((const __m128i*)palette), alphaIndicesSSE41(block));
+			}
+		}
+
+		template<Format F>
+		WMVX_TARGET_SSE41 inline void decodeBlockSSE41(const uint8_t* block, uint8_t* out, size_t stride) {
+			const uint8_t* color_block = colorBlock<F>(block);
+			const __m128i palette = colorPaletteSSE41<F>(block);
+
+			__m128i alphas = _mm_setzero_si128();
+			if constexpr (F != Format::BC1) {
+				alphas = blockAlphasSSE41<F>(block);
+			}
+
+			const __m128i alpha_lanes = _mm_set1_epi32((int)0xFF000000);
+
+			for (uint32_t r = 0; r < 4; r++) {
+				__m128i row = _mm_shuffle_epi8(palette, _mm_load_si128((const __m128i*)colorShuffles[color_block[4 + r]].bytes));
+
+				if constexpr (F != Format::BC1) {
+					const __m128i row_alpha = _mm_shuffle_epi8(alphas, _mm_load_si128((const __m128i*)alphaShuffles[r].bytes));
+					row = _mm_blendv_epi8(row, row_alpha, alpha_lanes);
+				}
+
+				_mm_storeu_si128((__m128i*)(out + r * stride), row);
+			}
+		}
+
+		template<Format F>
+		WMVX_TARGET_SSE41 void decodeSSE41(const uint8_t* src, uint32_t width, uint32_t height, uint32_t row_begin, uint32_t row_end, uint8_t* dest) {
+			const uint32_t blocks_x = BlockDecoder::blockCount(width);
+			const uint32_t full_x = width / 4;
+			const uint32_t full_y = height / 4;
+			const size_t stride = (size_t)width * 4;
+
+			for (uint32_t by = row_begin; by < row_end; by++) {
+				const uint8_t* block = src + (size_t)by * blocks_x * BlockDecoder::blockSize(F);
+				uint32_t bx = 0;
+
+				if (by < full_y) {
+					uint8_t* out = dest + (size_t)by * 4 * stride;
+					for (; bx < full_x; bx++, block += BlockDecoder::blockSize(F), out += 16) {
+						decodeBlockSSE41<F>(block, out, stride);
+					}
+				}
+
+				for (; bx < blocks_x; bx++, block += BlockDecoder::blockSize(F)) {
+					decodeEdgeBlock<F>(block, bx, by, width, height, dest);
+				}
+			}
+		}
+
+		// two horizontally adjacent blocks per iteration, each row of the pair is a single 32 byte store.
+		template<Format F>
+		WMVX_TARGET_AVX2 inline void decodeBlockPairAVX2(const uint8_t* block, uint8_t* out, size_t stride) {
+			const uint8_t* next = block + BlockDecoder::blockSize(F);
+			const uint8_t* color_block = colorBlock<F>(block);
+			const uint8_t* next_color_block = colorBlock<F>(next);
+
+			const __m256i palette = _mm256_inserti128_si256(_mm256_castsi128_si256(colorPaletteSSE41<F>(block)), colorPaletteSSE41<F>(next), 1);
+
+			__m256i alphas = _mm256_setzero_si256();
+			if constexpr (F != Format::BC1) {
+				alphas = _mm256_inserti128_si256(_mm256_castsi128_si256(blockAlphasSSE41<F>(block)), blockAlphasSSE41<F>(next), 1);
+			}
+
+			const __m256i alpha_lanes = _mm256_set1_epi32((int)0xFF000000);
+
+			for (uint32_t r = 0; r < 4; r++) {
+				const __m256i mask = _mm256_inserti128_si256(
+					_mm256_castsi128_si256(_mm_load_si128((const __m128i*)colorShuffles[color_block[4 + r]].bytes)),
+					_mm_load_si128((const __m128i*)colorShuffles[next_color_block[4 + r]].bytes),
+					1
+				);
+
+				__m256i row = _mm256_shuffle_epi8(palette, mask);
+
+				if constexpr (F != Format::BC1) {
+					const __m256i alpha_mask = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)alphaShuffles[r].bytes));
+					row = _mm256_blendv_epi8(row, _mm256_shuffle_epi8(alphas, alpha_mask), alpha_lanes);
+				}
+
+				_mm256_storeu_si256((__m256i*)(out + r * stride), row);
+			}
+		}
+
+		template<Format F>
+		WMVX_TARGET_AVX2 void decodeAVX2(const uint8_t* src, uint32_t width, uint32_t height, uint32_t row_begin, uint32_t row_end, uint8_t* dest) {
+			const uint32_t blocks_x = BlockDecoder::blockCount(width);
+			const uint32_t full_x = width / 4;
+			const uint32_t full_y = height / 4;
+			const size_t stride = (size_t)width * 4;
+
+			for (uint32_t by = row_begin; by < row_end; by++) {
+				const uint8_t* block = src + (size_t)by * blocks_x * BlockDecoder::blockSize(F);
+				uint32_t bx = 0;
+
+				if (by < full_y) {
+					uint8_t* out = dest + (size_t)by * 4 * stride;
+					for (; bx + 1 < full_x; bx += 2, block += 2 * BlockDecoder::blockSize(F), out += 32) {
+						decodeBlockPairAVX2<F>(block, out, stride);
+					}
+
+					if (bx < full_x) {
+						decodeBlockSSE41<F>(block, out, stride);
+						bx++;
+						block += BlockDecoder::blockSize(F);
+					}
+				}
+
+				for (; bx < blocks_x; bx++, block += BlockDecoder::blockSize(F)) {
+					decodeEdgeBlock<F>(block, bx, by, width, height, dest);
+				}
+			}
+		}
+
+		constexpr KernelTable sse41Kernels = { &decodeSSE41<Format::BC1>, &decodeSSE41<Format::BC2>, &decodeSSE41<Format::BC3> };
+		constexpr KernelTable avx2Kernels = { &decodeAVX2<Format::BC1>, &decodeAVX2<Format::BC2>, &decodeAVX2<Format::BC3> };
+
+#endif
+
+#if WMVX_BLOCKS_NEON
+
+		constexpr std::array<int16_t, 8> makeAlphaIndexShifts(uint32_t first_pixel) {
+			std::array<int16_t, 8> shifts{};
+			for (uint32_t i = 0; i < 8; i++) {
+				shifts[i] = -(int16_t)alphaIndexShift(first_pixel + i);
+			}
+			return shifts;
+		}
+
+		constexpr std::array<int16_t, 8> alphaIndexShiftsLow = makeAlphaIndexShifts(0);
+		constexpr std::array<int16_t, 8> alphaIndexShiftsHigh = makeAlphaIndexShifts(8);
+
+		// the 16 alpha indices of a BC3 block, one per byte. negative shifts are right shifts.
+		inline uint8x16_t alphaIndicesNEON(const uint8_t* block) {
+			const uint8x16_t raw = vcombine_u8(vld1_u8(block), vdup_n_u8(0));
+			const uint16x8_t mask = vdupq_n_u16(0x7);
+
+			const uint16x8_t low = vandq_u16(vshlq_u16(vreinterpretq_u16_u8(vqtbl1q_u8(raw, vld1q_u8(alphaIndexShuffles[0].bytes))), vld1q_s16(alphaIndexShiftsLow.data())), mask);
+			const uint16x8_t high = vandq_u16(vshlq_u16(vreinterpretq_u16_u8(vqtbl1q_u8(raw, vld1q_u8(alphaIndexShuffles[1].bytes))), vld1q_s16(alphaIndexShiftsHigh.data())), mask);
+
+			return vcombine_u8(vmovn_u16(low), vmovn_u16(high));
+		}
+
+		template<Format F>
+		inline void decodeBlockNEON(const uint8_t* block, uint8_t* out, size_t stride) {
+			const uint8_t* color_block = colorBlock<F>(block);
+
+			uint32_t palette_values[4];
+			colorPalette(color_block, palette_values);
+			const uint8x16_t palette = vreinterpretq_u8_u32(vld1q_u32(palette_values));
+
+			uint8x16_t alphas = vdupq_n_u8(0);
+			if constexpr (F == Format::BC2) {
+				const uint8x8_t raw = vld1_u8(block);
+				const uint8x8x2_t zipped = vzip_u8(vand_u8(raw, vdup_n_u8(0x0F)), vshr_n_u8(raw, 4));
+				const uint8x16_t nibbles = vcombine_u8(zipped.val[0], zipped.val[1]);
+				alphas = vorrq_u8(nibbles, vshlq_n_u8(nibbles, 4));
+			}
+			else if constexpr (F == Format::BC3) {
+				uint8_t alpha_palette[16] = {};
+				alphaPalette(block, alpha_palette);
+				alphas = vqtbl1q_u8(vld1q_u8(alpha_palette), alphaIndicesNEON(block));
+			}
+
+			const uint8x16_t alpha_lanes = vreinterpretq_u8_u32(vdupq_n_u32(0xFF000000));
+
+			for (uint32_t r = 0; r < 4; r++) {
+				uint8x16_t row = vqtbl1q_u8(palette, vld1q_u8(colorShuffles[color_block[4 + r]].bytes));
+
+				if constexpr (F != Format::BC1) {
+					row = vbslq_u8(alpha_lanes, vqtbl1q_u8(alphas, vld1q_u8(alphaShuffles[r].bytes)), row);
+				}
+
+				vst1q_u8(out + r * stride, row);
+			}
+		}
+
+		template<Format F>
+		void decodeNEON(const uint8_t* src, uint32_t width, uint32_t height, uint32_t row_begin, uint32_t row_end, uint8_t* dest) {
+			const uint32_t blocks_x = BlockDecoder::blockCount(width);
+			const uint32_t full_x = width / 4;
+			const uint32_t full_y = height / 4;
+			const size_t stride = (size_t)width * 4;
+
+			for (uint32_t by = row_begin; by < row_end; by++) {
+				const uint8_t* block = src + (size_t)by * blocks_x * BlockDecoder::blockSize(F);
+				uint32_t bx = 0;
+
+				if (by < full_y) {
+					uint8_t* out = dest + (size_t)by * 4 * stride;
+					for (; bx < full_x; bx++, block += BlockDecoder::blockSize(F), out += 16) {
+						decodeBlockNEON<F>(block, out, stride);
+					}
+				}
+
+				for (; bx < blocks_x; bx++, block += BlockDecoder::blockSize(F)) {
+					decodeEdgeBlock<F>(block, bx, by, width, height, dest);
+				}
+			}
+		}
+
+		constexpr KernelTable neonKernels = { &decodeNEON<Format::BC1>, &decodeNEON<Format::BC2>, &decodeNEON<Format::BC3> };
+
+#endif
+
+		BlockDecoder::Kernel detectKernel() {
+#if WMVX_BLOCKS_NEON
+			return BlockDecoder::Kernel::NEON;
+#elif WMVX_BLOCKS_X86
+#ifdef _MSC_VER
+			int info[4];
+			__cpuid(info, 0);
+			const int max_leaf = info[0];
+
+			__cpuid(info, 1);
+			const bool has_ssse3 = (info[2] & (1 << 9)) != 0;
+			const bool has_sse41 = (info[2] & (1 << 19)) != 0;
+			const bool has_osxsave = (info[2] & (1 << 27)) != 0;
+			const bool has_avx = (info[2] & (1 << 28)) != 0;
+
+			bool has_avx2 = false;
+			if (max_leaf >= 7) {
+				__cpuidex(info, 7, 0);
+				has_avx2 = (info[1] & (1 << 5)) != 0;
+			}
+
+			// the os must also save the ymm registers.
+			const bool has_ymm_state = has_osxsave && (_xgetbv(0) & 0x6) == 0x6;
+
+			if (has_avx && has_avx2 && has_ymm_state) {
+				return BlockDecoder::Kernel::AVX2;
+			}
+
+			if (has_ssse3 && has_sse41) {
+				return BlockDecoder::Kernel::SSE41;
+			}
+#else
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx2")) {
+				return BlockDecoder::Kernel::AVX2;
+			}
+
+			if (__builtin_cpu_supports("sse4.1")) {
+				return BlockDecoder::Kernel::SSE41;
+			}
+#endif
+#endif
+			return BlockDecoder::Kernel::SCALAR;
+		}
+
+		const KernelTable& kernelTable(BlockDecoder::Kernel kernel) {
+			switch (kernel) {
+#if WMVX_BLOCKS_X86
+			case BlockDecoder::Kernel::AVX2:
+				return avx2Kernels;
+			case BlockDecoder::Kernel::SSE41:
+				return sse41Kernels;
+#endif
+#if WMVX_BLOCKS_NEON
+			case BlockDecoder::Kernel::NEON:
+				return neonKernels;
+#endif
+			default:
+				return scalarKernels;
+			}
+		}
+	}
+
+	BlockDecoder::Kernel BlockDecoder::kernel() {
+		static const Kernel detected = detectKernel();
+		return detected;
+	}
+
+	bool BlockDecoder::supported(Kernel kernel) {
+		const Kernel detected = BlockDecoder::kernel();
+		return kernel == Kernel::SCALAR ||
+			kernel == detected ||
+			(kernel == Kernel::SSE41 && detected == Kernel::AVX2);
+	}
+
+	void BlockDecoder::decode(Format format, std::span<const uint8_t> src, uint32_t width, uint32_t height, uint8_t* dest) {
+		decode(format, src, width, height, dest, kernel());
+	}
+
+	void BlockDecoder::decode(Format format, std::span<const uint8_t> src, uint32_t width, uint32_t height, uint8_t* dest, Kernel kernel) {
+		assert(src.size() >= compressedSize(format, width, height));
+		assert(supported(kernel));
+
+		if (width == 0 || height == 0) {
+			return;
+		}
+
+		kernelTable(kernel)[(size_t)format](src.data(), width, height, 0, blockCount(height), dest);
+	}
+
+	void BlockDecoder::decodeRows(Format format, std::span<const uint8_t> src, uint32_t width, uint32_t height, uint32_t row_begin, uint32_t row_end, uint8_t* dest) {
+		assert(src.size() >= compressedSize(format, width, height));
+		assert(row_begin <= row_end && row_end <= blockCount(height));
+
+		if (width == 0 || row_begin >= row_end) {
+			return;
+		}
+
+		kernelTable(kernel())[(size_t)format](src.data(), width, height, row_begin, row_end, dest);
+	}
+};
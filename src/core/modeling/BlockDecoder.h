@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+namespace core {
+
+	/// <summary>
+	/// CPU decompression of BC1 / BC2 / BC3 (DXT1 / DXT3 / DXT5) textures to RGBA8.
+	/// Output is identical to the ddslib decoder used previously, including its colour expansion and 3 colour block handling,
+	/// except that partial blocks at the edges of images smaller than (or not a multiple of) 4 pixels are also written.
+	/// SSE4.1 / AVX2 / NEON kernels are selected at runtime, with a scalar fallback.
+	/// </summary>
+	class BlockDecoder {
+	public:
+		enum class Format : uint8_t {
+			BC1,
+			BC2,
+			BC3
+		};
+
+		enum class Kernel : uint8_t {
+			SCALAR,
+			SSE41,
+			AVX2,
+			NEON
+		};
+
+		// kernel used by decode(), detected once from the cpu features.
+		static Kernel kernel();
+
+		// true when the kernel can run on this cpu.
+		static bool supported(Kernel kernel);
+
+		static constexpr uint32_t blockSize(Format format) {
+			return format == Format::BC1 ? 8 : 16;
+		}
+
+		static constexpr uint32_t blockCount(uint32_t pixels) {
+			return (pixels + 3) / 4;
+		}
+
+		// bytes of compressed data needed for an image of the given size.
+		static constexpr size_t compressedSize(Format format, uint32_t width, uint32_t height) {
+			return (size_t)blockCount(width) * blockCount(height) * blockSize(format);
+		}
+
+		// src must hold at least compressedSize() bytes, dest width * height * 4 bytes.
+		static void decode(Format format, std::span<const uint8_t> src, uint32_t width, uint32_t height, uint8_t* dest);
+		static void decode(Format format, std::span<const uint8_t> src, uint32_t width, uint32_t height, uint8_t* dest, Kernel kernel);
+
+		// decodes only the block rows [row_begin, row_end), separate ranges of the same image may be decoded concurrently.
+		static void decodeRows(Format format, std::span<const uint8_t> src, uint32_t width, uint32_t height, uint32_t row_begin, uint32_t row_end, uint8_t* dest);
+	};
+};
@@ -437,11 +437,9 @@ namespace core {
 	{
 		fileDataDB = dynamic_cast<IFileDataGameDatabase*>(gameDB);
 
-		auto* const cascFS = (CascFileSystem*)(gameFS);
-
 		auto make_db = [&](const auto& db_name, const auto& def_name) {
 			auto schema = make_wbdr_schema(def_name, version);
-			auto file = cascFS->openFile(db_name);
+			auto file = gameFS->openFile(db_name);
 			auto casc_source = file->release();
 			auto memory_source = std::make_unique<WDBReader::Filesystem::MemoryFileSource>(*casc_source);
 			auto db = WDBReader::Database::makeDB2File(schema, std::move(memory_source));
@@ -490,24 +488,22 @@ namespace core {
 	}
 
 	void ModernCharacterCustomizationProvider::initialise(const CharacterDetails& details) {
-		auto* const cascFS = (CascFileSystem*)(gameFS);
-
 		auto model_id = getModelIdForCharacter(details);
 		assert(model_id > 0);
 
-		auto custom_file = cascFS->openFile("dbfilesclient/chrcustomization.db2");
+		auto custom_file = gameFS->openFile("dbfilesclient/chrcustomization.db2");
 		auto customs = WDBReader::Database::makeDB2File(
 			_schema_chr_custom,
 			custom_file->release()
 		);
 
-		auto opts_file = cascFS->openFile("dbfilesclient/chrcustomizationoption.db2");
+		auto opts_file = gameFS->openFile("dbfilesclient/chrcustomizationoption.db2");
 		auto custom_opts = WDBReader::Database::makeDB2File(
 			_schema_chr_option,
 			opts_file->release()
 		);
 
-		auto choice_file = cascFS->openFile("dbfilesclient/chrcustomizationchoice.db2");
+		auto choice_file = gameFS->openFile("dbfilesclient/chrcustomizationchoice.db2");
 		auto custom_choices = WDBReader::Database::makeDB2File(
 			_schema_chr_choice,
 			choice_file->release()
@@ -604,8 +600,6 @@ namespace core {
 
 	bool ModernCharacterCustomizationProvider::updateContext(Model* model, const CharacterDetails& details, const CharacterCustomizations& choices) {
 		
-		auto* const cascFS = (CascFileSystem*)(gameFS);
-
 		if (!context) {
 			context = std::make_shared<Context>();
 		}
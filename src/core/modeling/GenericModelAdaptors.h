@@ -204,6 +204,14 @@ namespace core {
 			}
 		}
 
+		constexpr virtual uint32_t getFlags() const {
+			return definition.flags;
+		}
+
+		constexpr virtual int16_t getNextVariationIndex() const {
+			return definition.nextAnimationId;
+		}
+
 	protected:
 		AnimationSequenceM2<R> definition;
 	};
@@ -224,9 +232,14 @@ namespace core {
 			pivot = Vector3::yUpToZUp(boneDefinition.pivot);
 			billboard = (boneDefinition.flags & ModelBoneFlags::spherical_billboard) != 0;
 		}
+		GenericModelBoneAdaptor(const GenericModelBoneAdaptor&) = default;
 		GenericModelBoneAdaptor(GenericModelBoneAdaptor&&) = default;
 		virtual ~GenericModelBoneAdaptor() {}
 
+		virtual std::unique_ptr<ModelBoneAdaptor> clone() const override {
+			return std::make_unique<GenericModelBoneAdaptor<R>>(*this);
+		}
+
 		AnimatedValue<Vector3, R> translation;
 		AnimatedValue<Quaternion, R> rotation;
 		AnimatedValue<Vector3, R> scale;
@@ -339,6 +352,153 @@ namespace core {
 		}
 	};
 
+	/// <summary>
+	/// Evaluates all bones of a model without recursion or virtual dispatch, producing the same results as GenericModelBoneAdaptor::calculateMatrix.
+	/// Bones are sorted once so every parent is evaluated before its children, the per frame pass is then a single loop over one contiguous array.
+	/// Each entry holds its own copy of the bone tracks, copies share the keyframes so only the small track headers are duplicated.
+	/// </summary>
+	template<M2_VER_RANGE R>
+	class GenericModelBoneEvaluator : public ModelBoneEvaluator {
+	public:
+		GenericModelBoneEvaluator(const std::vector<std::unique_ptr<ModelBoneAdaptor>>& bone_adaptors) {
+			const auto count = bone_adaptors.size();
+
+			enum class Mark : uint8_t { NONE, VISITING, DONE };
+			std::vector<Mark> marks(count, Mark::NONE);
+			std::vector<int32_t> resolved_parents(count, -1);
+			std::vector<size_t> order;
+			std::vector<size_t> chain;
+			order.reserve(count);
+
+			// walk up from each bone until reaching an evaluated (or root) bone, then emit the chain top down.
+			// parents which are out of range, or would form a cycle, are treated as roots.
+			for (size_t i = 0; i < count; i++) {
+				size_t current = i;
+				while (marks[current] == Mark::NONE) {
+					marks[current] = Mark::VISITING;
+					chain.push_back(current);
+
+					const auto* bone = static_cast<const GenericModelBoneAdaptor<R>*>(bone_adaptors[current].get());
+					const int32_t parent_id = bone->boneDefinition.parentBoneId;
+					if (parent_id < 0 || (size_t)parent_id >= count || marks[parent_id] == Mark::VISITING) {
+						break;
+					}
+
+					resolved_parents[current] = parent_id;
+					current = parent_id;
+				}
+
+				for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+					marks[*it] = Mark::DONE;
+					order.push_back(*it);
+				}
+				chain.clear();
+			}
+
+			std::vector<int32_t> position(count, -1);
+			for (size_t i = 0; i < count; i++) {
+				position[order[i]] = (int32_t)i;
+			}
+
+			bones.reserve(count);
+
+			for (const auto index : order) {
+				auto* bone = static_cast<GenericModelBoneAdaptor<R>*>(bone_adaptors[index].get());
+				bones.push_back({
+					bone->translation,
+					bone->rotation,
+					bone->scale,
+					bone->pivot,
+					resolved_parents[index] >= 0 ? position[resolved_parents[index]] : -1,
+					bone->billboard,
+					bone
+				});
+			}
+		}
+		GenericModelBoneEvaluator(GenericModelBoneEvaluator&&) = default;
+		virtual ~GenericModelBoneEvaluator() {}
+
+		std::unique_ptr<ModelBoneEvaluator> bind(const std::vector<std::unique_ptr<ModelBoneAdaptor>>& bone_adaptors) const override {
+			return std::make_unique<GenericModelBoneEvaluator<R>>(bone_adaptors);
+		}
+
+		void calculate(size_t animation_index, const AnimationTickArgs& tick) override {
+			const auto count = bones.size();
+
+			for (size_t i = 0; i < count; i++) {
+				const Bone& source = bones[i];
+				GenericModelBoneAdaptor<R>* bone = source.target;
+
+				const bool uses_translation = source.translation.uses(animation_index);
+				const bool uses_rotation = source.rotation.uses(animation_index);
+				const bool uses_scale = source.scale.uses(animation_index);
+
+				Matrix m;
+				Quaternion q;
+
+				if (uses_rotation || uses_scale || uses_translation || source.billboard) {
+					m.translation(source.pivot);
+
+					if (uses_translation) {
+						m *= Matrix::newTranslation(source.translation.getValue(animation_index, tick));
+					}
+
+					if (uses_rotation) {
+						q = source.rotation.getValue(animation_index, tick);
+						m *= Matrix::newQuatRotate(q);
+					}
+
+					if (uses_scale) {
+						m *= Matrix::newScale(source.scale.getValue(animation_index, tick));
+					}
+
+					m *= Matrix::newTranslation(source.pivot * -1.0f);
+				}
+				else {
+					m.unit();
+				}
+
+				const int32_t parent = source.parent;
+
+				if (parent >= 0) {
+					bone->mat = bones[parent].target->mat * m;
+				}
+				else {
+					bone->mat = m;
+				}
+
+				if (uses_rotation) {
+					if (parent >= 0) {
+						bone->mrot = bones[parent].target->mrot * Matrix::newQuatRotate(q);
+					}
+					else {
+						bone->mrot = Matrix::newQuatRotate(q);
+					}
+				}
+				else {
+					bone->mrot.unit();
+				}
+
+				bone->translationPivot = bone->mat * source.pivot;
+				bone->calculated = true;
+			}
+		}
+
+	protected:
+		struct Bone {
+			AnimatedValue<Vector3, R> translation;
+			AnimatedValue<Quaternion, R> rotation;
+			AnimatedValue<Vector3, R> scale;
+			Vector3 pivot;
+			int32_t parent;	// index into bones, -1 for roots.
+			bool billboard;
+			GenericModelBoneAdaptor<R>* target;	// receives the calculated matrices.
+		};
+
+		// in evaluation order.
+		std::vector<Bone> bones;
+	};
+
 
 
 	template<M2_VER_RANGE R>
@@ -365,9 +525,14 @@ namespace core {
 			segments.push_back(std::move(segment));
 
 		}
+		GenericModelRibbonEmitter(const GenericModelRibbonEmitter&) = default;
 		GenericModelRibbonEmitter(GenericModelRibbonEmitter&&) = default;
 		virtual ~GenericModelRibbonEmitter() {}
 
+		virtual std::unique_ptr<ModelRibbonEmitterAdaptor> clone() const override {
+			return std::make_unique<GenericModelRibbonEmitter<R>>(*this);
+		}
+
 		virtual void update(size_t animation_index, const AnimationTickArgs& tick, std::vector<ModelBoneAdaptor*>& allbones) {
 
 			const auto* parent_bone = allbones[definition.boneIndex];
@@ -472,9 +637,14 @@ namespace core {
 	class GenericModelParticleEmitterAdaptor : public ModelParticleEmitterAdaptor {
 	public:
 		GenericModelParticleEmitterAdaptor() = default;
+		GenericModelParticleEmitterAdaptor(const GenericModelParticleEmitterAdaptor&) = default;
 		GenericModelParticleEmitterAdaptor(GenericModelParticleEmitterAdaptor&&) = default;
 		virtual ~GenericModelParticleEmitterAdaptor() {}
 
+		virtual std::unique_ptr<ModelParticleEmitterAdaptor> clone() const override {
+			return std::make_unique<GenericModelParticleEmitterAdaptor<R>>(*this);
+		}
+
 		//TODO protect members
 
 		ModelParticleEmitterM2<R> definition;
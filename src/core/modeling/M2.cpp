@@ -3,13 +3,14 @@
 #include "../game/GameConstants.h"
 #include "../utility/Overload.h"
 #include "GenericModelAdaptors.h"
+#include <set>
 
 namespace core {
 
 	template<bool Strict = false>
 	struct ByteReader {
 	public:
-		ByteReader(uint8_t* data, size_t size) : pos(data), end(data + size), offset(0) {}
+		ByteReader(const uint8_t* data, size_t size) : pos(data), end(data + size), offset(0) {}
 		~ByteReader() {
 			assert(pos <= end);
 		}
@@ -30,7 +31,7 @@ namespace core {
 
 
 			if constexpr (std::is_scalar_v<val_t>) {
-				val = *reinterpret_cast<val_t*>(pos);
+				val = *reinterpret_cast<const val_t*>(pos);
 			}
 			else {
 				memcpy(&val, pos, sizeof(T));
@@ -61,12 +62,12 @@ namespace core {
 
 
 	protected:
-		uint8_t* pos;
-		uint8_t* end;
+		const uint8_t* pos;
+		const uint8_t* end;
 		size_t offset;
 	};
 
-	std::pair<M2Header, size_t> M2Header::create(std::span<uint8_t> buffer)
+	std::pair<M2Header, size_t> M2Header::create(std::span<const uint8_t> buffer)
 	{
 
 		M2Header header;
@@ -178,7 +179,8 @@ namespace core {
 		// non-chunked (legacy) files begin with MD20
 		const bool is_chunked_file = is_md21;
 
-		std::vector<uint8_t> md2x_buffer;
+		// view into the file content, remains valid while 'file' is open.
+		std::span<const uint8_t> md2x_buffer;
 
 		if (is_chunked_file) {
 			//TODO need better method for determining chunked file.
@@ -186,65 +188,105 @@ namespace core {
 			const auto md21_chunk = m2->_chunks.find(Signatures::MD21);
 			if (md21_chunk != m2->_chunks.end()) {
 				//MD21 chunk contains the content of the old MD20 format.
-				md2x_buffer.resize(md21_chunk->second.size);
-				file->read(md2x_buffer.data(), md21_chunk->second.size, md21_chunk->second.offset);
+				const auto file_data = file->data();
+				if (md21_chunk->second.offset + md21_chunk->second.size > file_data.size()) {
+					throw BadStructureException(uri.toString().toStdString(), "MD21 chunk extends beyond end of file.");
+				}
+				md2x_buffer = file_data.subspan(md21_chunk->second.offset, md21_chunk->second.size);
 			}
 			else {
 				throw BadStructureException("Unable to find MD21 chunk.");
 			}
 		}
 		else {
-			const auto file_size = file->getFileSize();
-			md2x_buffer.resize(file_size);
-			file->read(md2x_buffer.data(), file_size, 0);
+			md2x_buffer = file->data();
 		}
 
 		{
-			auto [header, header_bytes] = M2Header::create(std::span(md2x_buffer));
+			auto [header, header_bytes] = M2Header::create(md2x_buffer);
 			m2->_header = std::move(header);
 		}
 
+		// request the dependant files (skin, skeleton and textures) up front, so they load in the background while this file is parsed.
+		auto prefetched = [&]() -> std::future<void> {
+			std::vector<GameFileUri> dependants;
+
+			if (is_chunked_file) {
+				const auto file_data = file->data();
+
+				// skeleton and skin are the first id of their chunk, textures are an id per texture definition.
+				const std::array<std::pair<M2Signature, size_t>, 3> id_chunks = { {
+					{ Signatures::SKID, 1 },
+					{ Signatures::SFID, 1 },
+					{ Signatures::TXID, SIZE_MAX }
+				} };
+
+				for (const auto& [signature, max_count] : id_chunks) {
+					const auto chunk = m2->_chunks.find(signature);
+					if (chunk == m2->_chunks.end() || chunk->second.offset + chunk->second.size > file_data.size()) {
+						continue;
+					}
+
+					const auto count = std::min<size_t>(chunk->second.size / sizeof(uint32_t), max_count);
+					for (size_t i = 0; i < count; i++) {
+						uint32_t id;
+						memcpy(&id, file_data.data() + chunk->second.offset + (i * sizeof(uint32_t)), sizeof(id));
+						if (id > 0) {
+							dependants.push_back(id);
+						}
+					}
+				}
+			}
+			else if (m2->_header.version >= M2_VER_WOTLK) {
+				dependants.push_back(GameFileUri::removeExtension(m2->getFileInfo().path) + "00" + ".skin");
+			}
+
+			return fs->prefetch(dependants);
+		}();
+
 		// no-op placeholder for animated fix functions.
 		auto no_fix = [](auto&& val) { return val; };
 
 		m2->globalSequences = std::make_shared<std::vector<uint32_t>>();
 
-		std::map<size_t, ChunkedFile> animFiles;	//archive files keyed by animation_id
-
-		ChunkedFile skeleton_file = [&]() -> ChunkedFile {
+		// skeleton files are opened and indexed once here, every later stage reads from the same views.
+		const std::vector<SkeletonFile> skeleton_files = [&]() -> std::vector<SkeletonFile> {
 			const auto skid_chunk = m2->_chunks.find(Signatures::SKID);
 			if (skid_chunk != m2->_chunks.end()) {
 				Chunks::SKID skid;
 				assert(sizeof(skid) == skid_chunk->second.size);
 				file->read(&skid, skid_chunk->second.size, skid_chunk->second.offset);
 
-				return ChunkedFile(fs->openFile(skid.skeletonFileId));
+				return loadSkelFiles(fs, skid.skeletonFileId);
 			}
 
-			return ChunkedFile(nullptr);
+			return {};
 			}();
 
-		if (skeleton_file.file) {
-			processSkelFiles(fs, skeleton_file.file.get(), skeleton_file.chunks, [&](ArchiveFile* f, const ChunkedFile::Chunks& c, int32_t file_index) {
-				const auto sks1_chunk = c.find(Signatures::SKS1);
-				if (sks1_chunk != c.end()) {
+		m2->animationFiles = std::make_unique<AnimationFiles>(fs, !skeleton_files.empty() || (m2->_header.globalFlags & ModelGlobalFlags::CHUNKED_ANIM_0x2000));
+		AnimationFiles& animFiles = *m2->animationFiles;
+
+		if (!skeleton_files.empty()) {
+			for (const auto& skel : skeleton_files) {
+				const auto sks1_chunk = skel.chunks().find(Signatures::SKS1);
+				if (sks1_chunk != skel.chunks().end()) {
 					Chunks::SKS1 sks1;
 					assert(sizeof(sks1) <= sks1_chunk->second.size);
-					f->read(&sks1, sizeof(sks1), sks1_chunk->second.offset);
+					skel.read(&sks1, sizeof(sks1), sks1_chunk->second.offset);
 
 					if (sks1.globalSequences.size) {
 						decltype(m2->globalSequences)::element_type temp_sequences;
 						temp_sequences.resize(sks1.globalSequences.size);
-						f->read(temp_sequences.data(), sizeof(uint32_t) * sks1.globalSequences.size, sks1_chunk->second.offset + sks1.globalSequences.offset);
+						skel.read(temp_sequences.data(), sizeof(uint32_t) * sks1.globalSequences.size, sks1_chunk->second.offset + sks1.globalSequences.offset);
 						std::move(temp_sequences.begin(), temp_sequences.end(), std::back_inserter(*(m2->globalSequences)));
 					}
 				}
 
-				const auto ska1_chunk = c.find(Signatures::SKA1);
-				if (ska1_chunk != c.end()) {
+				const auto ska1_chunk = skel.chunks().find(Signatures::SKA1);
+				if (ska1_chunk != skel.chunks().end()) {
 					Chunks::SKA1 ska1;
 					assert(sizeof(ska1) <= ska1_chunk->second.size);
-					f->read(&ska1, sizeof(ska1), ska1_chunk->second.offset);
+					skel.read(&ska1, sizeof(ska1), ska1_chunk->second.offset);
 
 					//			//TODO it appears that attahcments should be overritten, not appended? - check.
 
@@ -257,7 +299,7 @@ namespace core {
 							[&]<M2_VER_RANGE R>() {
 							std::vector< ModelAttachmentM2<R>> attach_buffer;
 							attach_buffer.resize(ska1.attachments.size);
-							f->read(attach_buffer.data(), ska1.attachments.size * sizeof(ModelAttachmentM2<R>), ska1_chunk->second.offset + ska1.attachments.offset);
+							skel.read(attach_buffer.data(), ska1.attachments.size * sizeof(ModelAttachmentM2<R>), ska1_chunk->second.offset + ska1.attachments.offset);
 
 							for (auto& el : attach_buffer) {
 								m2->attachmentDefinitionAdaptors.push_back(
@@ -275,11 +317,11 @@ namespace core {
 					if (ska1.attachmentLookup.size) {
 						decltype(m2->attachmentLookups) temp_lookup;
 						temp_lookup.resize(ska1.attachmentLookup.size);
-						f->read(temp_lookup.data(), sizeof(uint16_t) * ska1.attachmentLookup.size, ska1_chunk->second.offset + ska1.attachmentLookup.offset);
+						skel.read(temp_lookup.data(), sizeof(uint16_t) * ska1.attachmentLookup.size, ska1_chunk->second.offset + ska1.attachmentLookup.offset);
 						std::move(temp_lookup.begin(), temp_lookup.end(), std::back_inserter(m2->attachmentLookups));
 					}
 				}
-				});
+			}
 		}
 		else if (m2->_header.globalSequences.size) {
 
@@ -378,7 +420,7 @@ namespace core {
 
 		{
 
-			auto load_indices = [&]<M2_VER_RANGE R>(const ModelViewM2<R>&view, std::span<uint8_t> skin_buffer) {
+			auto load_indices = [&]<M2_VER_RANGE R>(const ModelViewM2<R>&view, std::span<const uint8_t> skin_buffer) {
 				std::span<uint16_t> indexLookup((uint16_t*)(skin_buffer.data() + view.indices.offset), view.indices.size);
 				std::span<uint16_t> triangles((uint16_t*)(skin_buffer.data() + view.triangles.offset), view.triangles.size);
 
@@ -389,7 +431,7 @@ namespace core {
 				}
 			};
 
-			auto load_render_passes = [&]<M2_VER_RANGE R>(const ModelViewM2<R>&view, std::span<uint8_t> skin_buffer) {
+			auto load_render_passes = [&]<M2_VER_RANGE R>(const ModelViewM2<R>&view, std::span<const uint8_t> skin_buffer) {
 
 				std::span<ModelTextureUnitM2> modelTextureUnits((ModelTextureUnitM2*)(skin_buffer.data() + view.textureUnits.offset), view.textureUnits.size);
 				std::span<ModelRenderFlagsM2> render_flags_source((ModelRenderFlagsM2*)(md2x_buffer.data() + m2->_header.renderFlags.offset), m2->_header.renderFlags.size);
@@ -468,10 +510,7 @@ namespace core {
 					}
 
 					if (skinFile) {
-						const auto skinSize = skinFile->getFileSize();
-						auto skinBuffer = std::vector<uint8_t>(skinSize);
-						skinFile->read(skinBuffer.data(), skinSize);
-						skinFile.reset();
+						const auto skinBuffer = skinFile->data();
 
 
 						bool match_view_type = M2_VER_RANGE_LIST<
@@ -488,7 +527,7 @@ namespace core {
 								throw BadSignatureException("Invalid SKIN id.");
 							}
 
-							load_indices(*view, std::span(skinBuffer));
+							load_indices(*view, skinBuffer);
 
 							std::vector<ModelGeosetM2<R>> geosets(view->submeshes.size);
 							memcpy(geosets.data(), skinBuffer.data() + view->submeshes.offset, sizeof(ModelGeosetM2<R>) * view->submeshes.size);
@@ -514,7 +553,7 @@ namespace core {
 								}
 							}
 
-							load_render_passes(*view, std::span(skinBuffer));
+							load_render_passes(*view, skinBuffer);
 
 						});
 
@@ -544,7 +583,7 @@ namespace core {
 
 							ModelViewM2<R>& view = views[0];
 
-							load_indices(view, std::span(md2x_buffer));
+							load_indices(view, md2x_buffer);
 
 							bool match_geoset_type = M2_VER_RANGE_LIST<
 								M2_VER_RANGE::FROM(M2_VER_TBC_MIN),
@@ -565,7 +604,7 @@ namespace core {
 								throw BadStructureException("Unable to read geosets structures.");
 							}
 
-							load_render_passes(view, std::span(md2x_buffer));
+							load_render_passes(view, md2x_buffer);
 						});
 
 
@@ -579,15 +618,14 @@ namespace core {
 
 
 		{
-			//TODO combine 'processSkelFiles' calls if possible.
 			std::vector<Chunks::AFID> afids;
-			if (skeleton_file.file) {
-				processSkelFiles(fs, skeleton_file.file.get(), skeleton_file.chunks, [&](ArchiveFile* f, const ChunkedFile::Chunks& c, int32_t file_index) {
-					const auto sks1_chunk = c.find(Signatures::SKS1);
-					if (sks1_chunk != c.end()) {
+			if (!skeleton_files.empty()) {
+				for (const auto& skel : skeleton_files) {
+					const auto sks1_chunk = skel.chunks().find(Signatures::SKS1);
+					if (sks1_chunk != skel.chunks().end()) {
 						Chunks::SKS1 sks1;
 						assert(sizeof(sks1) <= sks1_chunk->second.size);
-						f->read(&sks1, sizeof(sks1), sks1_chunk->second.offset);
+						skel.read(&sks1, sizeof(sks1), sks1_chunk->second.offset);
 
 
 						// note animation sequnces can replace parent items from the child file, and when doing so they are not in the same order or size.
@@ -602,7 +640,7 @@ namespace core {
 								[&]<M2_VER_RANGE R>() {
 								std::vector<AnimationSequenceM2<R>> anim_buffer;
 								anim_buffer.resize(sks1.animations.size);
-								f->read(anim_buffer.data(), sks1.animations.size * sizeof(AnimationSequenceM2<R>), sks1_chunk->second.offset + sks1.animations.offset);
+								skel.read(anim_buffer.data(), sks1.animations.size * sizeof(AnimationSequenceM2<R>), sks1_chunk->second.offset + sks1.animations.offset);
 
 								for (auto& seq : anim_buffer) {
 									auto existing_seq = std::find_if(m2->animationSequenceAdaptors.begin(), m2->animationSequenceAdaptors.end(), [&seq](const auto/*ModelAnimationSequenceAdaptor*/& existing) -> bool {
@@ -629,19 +667,19 @@ namespace core {
 						if (sks1.animationLookup.size) {
 							decltype(m2->animationLookups) temp_lookups;
 							temp_lookups.resize(sks1.animationLookup.size);
-							f->read(temp_lookups.data(), sizeof(uint16_t) * sks1.animationLookup.size, sks1_chunk->second.offset + sks1.animationLookup.offset);
+							skel.read(temp_lookups.data(), sizeof(uint16_t) * sks1.animationLookup.size, sks1_chunk->second.offset + sks1.animationLookup.offset);
 							std::move(temp_lookups.begin(), temp_lookups.end(), std::back_inserter(m2->animationLookups));
 						}
 					}
 
-					const auto afid_chunk = c.find(Signatures::AFID);
-					if (afid_chunk != c.end()) {
+					const auto afid_chunk = skel.chunks().find(Signatures::AFID);
+					if (afid_chunk != skel.chunks().end()) {
 						std::vector<Chunks::AFID> temp_afids;
 						temp_afids.resize(afid_chunk->second.size / sizeof(Chunks::AFID));
-						f->read(temp_afids.data(), afid_chunk->second.size, afid_chunk->second.offset);
+						skel.read(temp_afids.data(), afid_chunk->second.size, afid_chunk->second.offset);
 						std::move(temp_afids.begin(), temp_afids.end(), std::back_inserter(afids));
 					}
-					});
+				}
 			}
 			else {
 
@@ -684,36 +722,42 @@ namespace core {
 				}
 			}
 
-			size_t anim_index = 0;
-			for (const auto& anim_seq : m2->animationSequenceAdaptors) {
-				const auto mainAnimId = anim_seq->getId();
-				const auto subAnimId = anim_seq->getVariationId();
-
-				std::unique_ptr<ArchiveFile> animFile = nullptr;
-
-				if (afids.size() > 0) {
-					auto matching_afid = std::find_if(afids.begin(), afids.end(), [&](const Chunks::AFID& afid) {
-						return mainAnimId == afid.animationId &&
-							subAnimId == afid.variationId &&
-							afid.fileId > 0;
-						});
+			// external animation files are only resolved here, each is read on first use of the animation (see M2Data::loadAnimation.)
+			// animation files were added in wotlk, older models store all animation data within the model file.
+			if (m2->_header.version >= M2_VER_WOTLK) {
+				size_t anim_index = 0;
+				for (const auto& anim_seq : m2->animationSequenceAdaptors) {
+					const auto mainAnimId = anim_seq->getId();
+					const auto subAnimId = anim_seq->getVariationId();
+
+					if (afids.size() > 0) {
+						auto matching_afid = std::find_if(afids.begin(), afids.end(), [&](const Chunks::AFID& afid) {
+							return mainAnimId == afid.animationId &&
+								subAnimId == afid.variationId &&
+								afid.fileId > 0;
+							});
 
-					if (matching_afid != afids.end()) {
-						animFile = std::move(fs->openFile(matching_afid->fileId));
+						if (matching_afid != afids.end()) {
+							animFiles.add(anim_index, matching_afid->fileId);
+						}
+					}
+					else if (m2->_chunks.size() == 0 && (anim_seq->getFlags() & ModelAnimationFlags::PRIMARY_BONE_SEQUENCE) == 0) {
+						const QString& fileName = m2->getFileInfo().path;
+						QString animName = fileName.mid(0, fileName.lastIndexOf('.')) + QString("%1-%2.anim").arg(QString::number(mainAnimId), 4, '0').arg(QString::number(subAnimId), 2, '0');
+						animFiles.add(anim_index, animName);
 					}
-				}
-				else if (m2->_chunks.size() == 0) {
-					const QString& fileName = m2->getFileInfo().path;
-					QString animName = fileName.mid(0, fileName.lastIndexOf('.')) + QString("%1-%2.anim").arg(QString::number(mainAnimId), 4, '0').arg(QString::number(subAnimId), 2, '0');
-					animFile = std::move(fs->openFile(animName));
-				}
 
-				if (animFile != nullptr) {
-					const bool is_chunked_anim_file = skeleton_file.file || (m2->_header.globalFlags & ModelGlobalFlags::CHUNKED_ANIM_0x2000);
-					animFiles.emplace(anim_index, ChunkedFile(std::move(animFile), is_chunked_anim_file));
+					anim_index++;
 				}
 
-				anim_index++;
+				// the stand animation is almost always shown first, start reading it while the rest of the model loads.
+				const auto stand = std::find_if(m2->animationSequenceAdaptors.begin(), m2->animationSequenceAdaptors.end(), [](const auto& anim_seq) {
+					return anim_seq->getId() == 0 && anim_seq->getVariationId() == 0;
+				});
+
+				if (stand != m2->animationSequenceAdaptors.end()) {
+					animFiles.prefetch(std::distance(m2->animationSequenceAdaptors.begin(), stand));
+				}
 			}
 		}
 
@@ -809,7 +853,7 @@ namespace core {
 				{
 					//bones
 
-					auto load_bones = [&](std::vector<ModelBoneM2<R>>&& bonesDefinitions, const std::vector<uint8_t>& src_buffer) {
+					auto load_bones = [&](std::vector<ModelBoneM2<R>>&& bonesDefinitions, std::span<const uint8_t> buffer_view) {
 						if (bonesDefinitions.size()) {
 							m2->boneAdaptors.reserve(m2->boneAdaptors.size() + bonesDefinitions.size());
 
@@ -817,8 +861,6 @@ namespace core {
 								return Quaternion(-q.x, -q.z, q.y, q.w);
 								};
 
-							const std::span<uint8_t> buffer_view(*const_cast<std::decay_t<decltype(src_buffer)>*>(&src_buffer));
-
 							for (ModelBoneM2<R>& boneDef : bonesDefinitions) {
 								auto trans_data = AnimationBlock<Vector3, R>::fromDefinition(boneDef.translation, buffer_view, animFiles);
 								auto scale_data = AnimationBlock<Vector3, R>::fromDefinition(boneDef.scale, buffer_view, animFiles);
@@ -856,31 +898,27 @@ namespace core {
 						}
 						};
 
-					if (skeleton_file.file) {
-						processSkelFiles(fs, skeleton_file.file.get(), skeleton_file.chunks, [&](ArchiveFile* f, const ChunkedFile::Chunks& c, int32_t file_index) {
-							const auto skb1_chunk = c.find(Signatures::SKB1);
-							if (skb1_chunk != c.end()) {
+					if (!skeleton_files.empty()) {
+						for (const auto& skel : skeleton_files) {
+							const auto skb1_chunk = skel.chunks().find(Signatures::SKB1);
+							if (skb1_chunk != skel.chunks().end()) {
 								Chunks::SKB1 skb1;
 								assert(sizeof(skb1) <= skb1_chunk->second.size);
-								f->read(&skb1, sizeof(skb1), skb1_chunk->second.offset);
+								skel.read(&skb1, sizeof(skb1), skb1_chunk->second.offset);
 
 								if (skb1.keyBoneLookup.size) {
 									decltype(m2->keyBoneLookup) temp_lookup;
 									temp_lookup.resize(skb1.keyBoneLookup.size);
-									f->read(temp_lookup.data(), sizeof(int16_t) * skb1.keyBoneLookup.size, skb1_chunk->second.offset + skb1.keyBoneLookup.offset);
+									skel.read(temp_lookup.data(), sizeof(int16_t) * skb1.keyBoneLookup.size, skb1_chunk->second.offset + skb1.keyBoneLookup.offset);
 									std::move(temp_lookup.begin(), temp_lookup.end(), std::back_inserter(m2->keyBoneLookup));
 								}
 
 								auto temp_bonesDefinitions = std::vector<ModelBoneM2<R>>(skb1.bones.size);
-								f->read(temp_bonesDefinitions.data(), sizeof(ModelBoneM2<R>) * skb1.bones.size, skb1_chunk->second.offset + skb1.bones.offset);
+								skel.read(temp_bonesDefinitions.data(), sizeof(ModelBoneM2<R>) * skb1.bones.size, skb1_chunk->second.offset + skb1.bones.offset);
 
-								const auto skel_size = f->getFileSize();
-								auto temp_src_buffer = std::vector<uint8_t>(skel_size - skb1_chunk->second.offset);
-								f->read(temp_src_buffer.data(), temp_src_buffer.size(), skb1_chunk->second.offset);
-
-								load_bones(std::move(temp_bonesDefinitions), temp_src_buffer);
+								load_bones(std::move(temp_bonesDefinitions), skel.buffer.subspan(skb1_chunk->second.offset));
 							}
-							});
+						}
 					}
 					else {
 						if (m2->_header.keyBoneLookup.size) {
@@ -894,6 +932,10 @@ namespace core {
 
 						load_bones(std::move(bonesDefinitions), md2x_buffer);
 					}
+
+					if (m2->boneAdaptors.size()) {
+						m2->boneEvaluator = std::make_unique<GenericModelBoneEvaluator<R>>(m2->boneAdaptors);
+					}
 				}
 		}
 		);
@@ -1083,5 +1125,184 @@ namespace core {
 
 	}
 
-	
+	std::vector<SkeletonFile> M2Loader::loadSkelFiles(GameFileSystem* fs, uint32_t skeleton_id)
+	{
+		std::vector<SkeletonFile> result;
+		// the starting id is included, so a parent pointing back at the models own skeleton also stops the walk.
+		std::set<uint32_t> visited{ skeleton_id };
+		auto skeleton = fs->openFile(skeleton_id);
+
+		while (skeleton != nullptr) {
+			ChunkedFile source(std::move(skeleton));
+			const auto buffer = source.file->data();
+			uint32_t parent_id = 0;
+
+			const auto skpd_chunk = source.chunks.find(Signatures::SKPD);
+			if (skpd_chunk != source.chunks.end()) {
+				Chunks::SKPD skpd;
+				assert(sizeof(skpd) <= skpd_chunk->second.size);
+				if (skpd_chunk->second.offset + sizeof(skpd) <= buffer.size()) {
+					memcpy(&skpd, buffer.data() + skpd_chunk->second.offset, sizeof(skpd));
+					parent_id = skpd.parentSkelFileId;
+				}
+			}
+
+			result.push_back(SkeletonFile{ std::move(source), buffer });
+
+			// guard against malformed files referencing themselves.
+			if (parent_id && visited.insert(parent_id).second) {
+				skeleton = fs->openFile(parent_id);
+			}
+		}
+
+		// parents are applied before their children.
+		std::reverse(result.begin(), result.end());
+
+		return result;
+	}
+
+	std::shared_ptr<M2Data> M2Data::load(GameFileSystem* fs, const GameFileUri& uri)
+	{
+		auto m2 = std::make_shared<M2Data>();
+
+		M2Loader loader(m2.get(), fs, uri);
+		m2->modelPathInfo = ModelPathInfo(m2->getFileInfo().path, fs);
+		m2->renderPasses = std::move(loader.renderPasses);
+		m2->textureLoadDefinitions = std::move(loader.textures);
+
+		return m2;
+	}
+
+	void M2Data::loadAnimation(size_t animation_index) const
+	{
+		if (!animationFiles || animationFiles->isLoaded(animation_index)) {
+			return;
+		}
+
+		animationFiles->load(animation_index);
+
+		if (animation_index < animationSequenceAdaptors.size()) {
+			const int16_t next_variation = animationSequenceAdaptors[animation_index]->getNextVariationIndex();
+			if (next_variation >= 0 && (size_t)next_variation != animation_index) {
+				animationFiles->prefetch(next_variation);
+			}
+		}
+	}
+
+	void M2Data::detachFileSystem() const
+	{
+		if (animationFiles) {
+			animationFiles->detach();
+		}
+	}
+
+	M2Model::make_result_t M2Model::make(GameFileSystem* fs, const GameFileUri& uri)
+	{
+		auto data = M2DataCache::global().get(fs, uri);
+		auto textures = data->getTextureLoadDefinitions();
+
+		return std::make_pair(std::make_unique<M2Model>(std::move(data)), std::move(textures));
+	}
+
+	M2Model::M2Model(std::shared_ptr<const M2Data> source) : data(std::move(source))
+	{
+		boneAdaptors.reserve(data->boneAdaptors.size());
+		for (const auto& bone : data->boneAdaptors) {
+			boneAdaptors.push_back(bone->clone());
+		}
+
+		if (data->boneEvaluator) {
+			boneEvaluator = data->boneEvaluator->bind(boneAdaptors);
+		}
+
+		ribbonAdaptors.reserve(data->ribbonAdaptors.size());
+		for (const auto& ribbon : data->ribbonAdaptors) {
+			ribbonAdaptors.push_back(ribbon->clone());
+		}
+
+		particleAdaptors.reserve(data->particleAdaptors.size());
+		for (const auto& particle : data->particleAdaptors) {
+			particleAdaptors.push_back(particle->clone());
+		}
+	}
+
+	std::shared_ptr<const M2Data> M2DataCache::get(GameFileSystem* fs, const GameFileUri& uri)
+	{
+		const GameFileInfo info = fs->asInfo(uri);
+		if (info.id == 0 && info.path.isEmpty()) {
+			std::shared_ptr<const M2Data> loaded = M2Data::load(fs, uri);
+
+			std::scoped_lock lock(mutex);
+			std::erase_if(unshared, [](const auto& entry) {
+				return entry.second.expired();
+			});
+			unshared.emplace_back(fs, loaded);
+			return loaded;
+		}
+
+		const key_t key = info.id != 0 ? key_t(fs, info.id, {}) : key_t(fs, 0u, info.path.toLower());
+
+		{
+			std::scoped_lock lock(mutex);
+			const auto it = entries.find(key);
+			if (it != entries.end()) {
+				if (auto existing = it->second.lock()) {
+					return existing;
+				}
+			}
+		}
+
+		// loaded without holding the lock, so different models can load in parallel.
+		std::shared_ptr<const M2Data> loaded = M2Data::load(fs, uri);
+
+		std::scoped_lock lock(mutex);
+		std::erase_if(entries, [](const auto& entry) {
+			return entry.second.expired();
+		});
+
+		auto& entry = entries[key];
+		if (auto existing = entry.lock()) {
+			// another thread finished loading the same file first.
+			return existing;
+		}
+
+		entry = loaded;
+		return loaded;
+	}
+
+	void M2DataCache::release(const GameFileSystem* fs)
+	{
+		std::scoped_lock lock(mutex);
+
+		for (const auto& [key, entry] : entries) {
+			if (std::get<0>(key) == fs) {
+				if (auto data = entry.lock()) {
+					data->detachFileSystem();
+				}
+			}
+		}
+
+		for (const auto& [owner, entry] : unshared) {
+			if (owner == fs) {
+				if (auto data = entry.lock()) {
+					data->detachFileSystem();
+				}
+			}
+		}
+
+		// entries are keyed by address, a later file system could be allocated at the same one and must not match them.
+		std::erase_if(entries, [fs](const auto& entry) {
+			return std::get<0>(entry.first) == fs;
+		});
+
+		std::erase_if(unshared, [fs](const auto& entry) {
+			return entry.first == fs;
+		});
+	}
+
+	M2DataCache& M2DataCache::global()
+	{
+		static M2DataCache cache;
+		return cache;
+	}
 }
\ No newline at end of file
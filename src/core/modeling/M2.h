@@ -6,9 +6,13 @@
 #include "Animation.h"
 #include "ModelAdaptors.h"
 #include "ModelPathInfo.h"
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <span>
+#include <tuple>
 #include <variant>
 #include <cstdint>
 #include <utility>
@@ -23,7 +27,7 @@ namespace core {
 	public:
 
 		// Reads the header from the buffer, returns the header and number of bytes read.
-		static std::pair<M2Header, size_t> create(std::span<uint8_t> buffer);
+		static std::pair<M2Header, size_t> create(std::span<const uint8_t> buffer);
 
 		std::array<uint8_t, 4> magic;
 		uint32_t version;
@@ -73,6 +77,26 @@ namespace core {
 
 	class M2Data;
 
+	/// <summary>
+	/// A single skeleton file, opened and chunk indexed once, then shared by every stage of the model load.
+	/// </summary>
+	struct SkeletonFile {
+		ChunkedFile source;
+		std::span<const uint8_t> buffer;
+
+		const ChunkedFile::Chunks& chunks() const {
+			return source.chunks;
+		}
+
+		void read(void* dest, size_t bytes, size_t offset) const {
+			if (offset > buffer.size() || bytes > buffer.size() - offset) {
+				throw BadStructureException("Read extends beyond end of skeleton file.");
+			}
+
+			memcpy(dest, buffer.data() + offset, bytes);
+		}
+	};
+
 	class M2Loader {
 	public:
 		M2Loader(M2Data* m2, GameFileSystem* fs, const GameFileUri& uri) {
@@ -86,36 +110,96 @@ namespace core {
 
 	protected:
 
-		// apply a callback for each skeleton file, starting the at top most parent.
-		template<typename fn>
-		void processSkelFiles(GameFileSystem* fs, ArchiveFile* file, const ChunkedFile::Chunks& chunks, fn callback, int32_t file_index = 0) {
-			if (file != nullptr) {
-				const auto skpd_chunk = chunks.find(Signatures::SKPD);
-				if (skpd_chunk != chunks.end()) {
-					Chunks::SKPD skpd;
-					assert(sizeof(skpd) <= skpd_chunk->second.size);
-					file->read(&skpd, sizeof(skpd), skpd_chunk->second.offset);
-
-					if (skpd.parentSkelFileId) {
-						std::unique_ptr<ArchiveFile> parent_file(fs->openFile(skpd.parentSkelFileId));
-						if (parent_file != nullptr) {
-							ChunkedFile::Chunks parent_chunks = ChunkedFile::getChunks(parent_file.get());
-							processSkelFiles(fs, parent_file.get(), parent_chunks, callback, ++file_index);
-						}
-					}
-				}
-
-				callback(file, chunks, file_index);
-			}
+		// open the skeleton file and each of its parents, ordered from the top most parent down to the models own skeleton file.
+		static std::vector<SkeletonFile> loadSkelFiles(GameFileSystem* fs, uint32_t skeleton_id);
+	};
+
+
+	//TODO move to better location
+	// not part of M2, but used by wmv for rendering.
+	struct TextureLoadDef {
+		size_t index; 
+		ModelTextureM2 defintion;
+		GameFileUri uri;
+	};
+
+	struct ModelRenderPass {
+
+		ModelRenderPass(
+			const ModelRenderFlagsM2& render_flags,
+			const ModelTextureUnitM2& texture_unit
+		) {
+			useTex2 = false;
+			useEnvMap = false;
+			trans = false;
+			texanim = -1; // no texture animation
+
+			blendmode = render_flags.blend;
+
+			unlit = (render_flags.flags & RenderFlags::UNLIT) != 0;
+			cull = (render_flags.flags & RenderFlags::TWO_SIDED) == 0;
+			billboard = (render_flags.flags & RenderFlags::BILLBOARD) != 0;
+
+			useEnvMap = (texture_unit.textureUnitIndex == -1) && billboard && render_flags.blend > 2;
+
+			noZWrite = (render_flags.flags & RenderFlags::ZBUFFERED) != 0;
+
+			geosetIndex = texture_unit.submeshIndex;
+			color = texture_unit.colorIndex;
 		}
 
-		
+		ModelRenderPass(ModelRenderPass&&) = default;
+
+		uint32_t indexStart;
+		uint32_t indexCount;
+		uint32_t vertexStart;
+		uint32_t vertexEnd;
+
+		int32_t tex;
+		bool useTex2;
+		bool useEnvMap;
+		bool cull;
+		bool trans;
+		bool unlit;
+		bool noZWrite;
+		bool billboard;
+
+		float p;
+
+		int16_t texanim;
+		int16_t color;
+		int16_t opacity;
+		int16_t blendmode;
+
+		int32_t geosetIndex;
+
+		bool swrap;
+		bool twrap;
+
+		ColorRGBA<float> ocol;
+		ColorRGBA<float> ecol;
+
+		bool operator< (const ModelRenderPass& m) const
+		{
+			//TODO not sure if still used - remove if not.
+			// 
+			// This is the old sort order method which I'm pretty sure is wrong - need to try something else.
+			// Althogh transparent part should be displayed later, but don't know how to sort it
+			// And it will sort by geoset id now.
+			return geosetIndex < m.geosetIndex;
+		}
 	};
 
 
+
+	/// <summary>
+	/// Parsed content of a model file, never modified once loaded so may be shared by any number of M2Model instances.
+	/// </summary>
 	class M2Data {
 	public:
 
+		static std::shared_ptr<M2Data> load(GameFileSystem* fs, const GameFileUri& uri);
+
 		const M2Signature& getMagic() const {
 			return _magic;
 		}
@@ -132,6 +216,18 @@ namespace core {
 			return fileInfo;
 		}
 
+		const ModelPathInfo& getModelPathInfo() const {
+			return modelPathInfo;
+		}
+
+		const std::vector<ModelRenderPass>& getRenderPasses() const {
+			return renderPasses;
+		}
+
+		const std::vector<TextureLoadDef>& getTextureLoadDefinitions() const {
+			return textureLoadDefinitions;
+		}
+
 		const std::vector<ModelGeosetAdaptor*>& getGeosetAdaptors() const {
 			return reinterpret_cast<const std::vector<ModelGeosetAdaptor*>&>(geosetAdaptors);
 		}
@@ -212,6 +308,13 @@ namespace core {
 			return attachmentLookups;
 		}
 
+		// reads any data for the animation stored in external .anim files, then starts prefetching the animations next variation.
+		// cheap once loaded, must be called before the animation is evaluated.
+		void loadAnimation(size_t animation_index) const;
+
+		// stop reading external animations, see AnimationFiles::detach - animations not yet loaded are left empty.
+		void detachFileSystem() const;
+
 
 	protected:
 		M2Signature _magic;
@@ -226,12 +329,14 @@ namespace core {
 		std::vector<std::unique_ptr<ModelTransparencyAdaptor>> transparencyAdaptors;
 
 		std::vector<std::unique_ptr<ModelBoneAdaptor>> boneAdaptors;
+		std::unique_ptr<ModelBoneEvaluator> boneEvaluator;
 		std::vector<std::unique_ptr<ModelAttachmentDefinitionAdaptor>> attachmentDefinitionAdaptors;
 
 		std::vector<std::unique_ptr<ModelRibbonEmitterAdaptor>> ribbonAdaptors;
 		std::vector<std::unique_ptr<ModelParticleEmitterAdaptor>> particleAdaptors;	
 
 		std::shared_ptr<std::vector<uint32_t>> globalSequences;
+		std::unique_ptr<AnimationFiles> animationFiles;
 
 		std::vector<Vector3> vertices;
 		std::vector<Vector3> normals;
@@ -246,114 +351,145 @@ namespace core {
 		std::vector<int16_t> keyBoneLookup;
 		std::vector<uint16_t> animationLookups; 
 
+		std::vector<ModelRenderPass> renderPasses;
+		std::vector<TextureLoadDef> textureLoadDefinitions;
+
 	private:
 		GameFileInfo fileInfo;
+		ModelPathInfo modelPathInfo;
 
 		friend class M2Loader;
+		friend class M2Model;
 	};
 
 
 
-	//TODO move to better location
-	// not part of M2, but used by wmv for rendering.
-	struct TextureLoadDef {
-		size_t index; 
-		ModelTextureM2 defintion;
-		GameFileUri uri;
-	};
+	/// <summary>
+	/// An instance of a model, the parsed file is shared by every instance of the same model (see M2DataCache.)
+	/// Only state which changes while animating belongs to the instance, bone matrices, particles and ribbons.
+	/// </summary>
+	class M2Model {
+	public:
 
-	struct ModelRenderPass {
+		using make_result_t = std::pair<std::unique_ptr<M2Model>, std::vector<TextureLoadDef>>;
+		using Factory = std::function<make_result_t(GameFileSystem*, const GameFileUri&)>;
 
-		ModelRenderPass(
-			const ModelRenderFlagsM2& render_flags,
-			const ModelTextureUnitM2& texture_unit
-		) {
-			useTex2 = false;
-			useEnvMap = false;
-			trans = false;
-			texanim = -1; // no texture animation
+		static make_result_t make(GameFileSystem* fs, const GameFileUri& uri);
 
-			blendmode = render_flags.blend;
+		explicit M2Model(std::shared_ptr<const M2Data> source);
+		M2Model(M2Model&&) = default;
+		virtual ~M2Model() {}
 
-			unlit = (render_flags.flags & RenderFlags::UNLIT) != 0;
-			cull = (render_flags.flags & RenderFlags::TWO_SIDED) == 0;
-			billboard = (render_flags.flags & RenderFlags::BILLBOARD) != 0;
+		const M2Data& getData() const {
+			return *data;
+		}
 
-			useEnvMap = (texture_unit.textureUnitIndex == -1) && billboard && render_flags.blend > 2;
+		const M2Signature& getMagic() const {
+			return data->getMagic();
+		}
 
-			noZWrite = (render_flags.flags & RenderFlags::ZBUFFERED) != 0;
+		const M2Header& getHeader() const {
+			return data->getHeader();
+		}
 
-			geosetIndex = texture_unit.submeshIndex;
-			color = texture_unit.colorIndex;
+		const ChunkedFile::Chunks& getChunks() const {
+			return data->getChunks();
 		}
 
-		ModelRenderPass(ModelRenderPass&&) = default;
+		const GameFileInfo& getFileInfo() const {
+			return data->getFileInfo();
+		}
 
-		uint32_t indexStart;
-		uint32_t indexCount;
-		uint32_t vertexStart;
-		uint32_t vertexEnd;
+		const ModelPathInfo& getModelPathInfo() const {
+			return data->getModelPathInfo();
+		}
 
-		int32_t tex;
-		bool useTex2;
-		bool useEnvMap;
-		bool cull;
-		bool trans;
-		bool unlit;
-		bool noZWrite;
-		bool billboard;
+		const std::vector<ModelRenderPass>& getRenderPasses() const {
+			return data->getRenderPasses();
+		}
 
-		float p;
+		const std::vector<ModelGeosetAdaptor*>& getGeosetAdaptors() const {
+			return data->getGeosetAdaptors();
+		}
 
-		int16_t texanim;
-		int16_t color;
-		int16_t opacity;
-		int16_t blendmode;
+		const std::vector<ModelAnimationSequenceAdaptor*>& getModelAnimationSequenceAdaptors() const {
+			return data->getModelAnimationSequenceAdaptors();
+		}
 
-		int32_t geosetIndex;
+		const std::vector<ModelTextureAnimationAdaptor*>& getTextureAnimationAdaptors() const {
+			return data->getTextureAnimationAdaptors();
+		}
 
-		bool swrap;
-		bool twrap;
+		const std::vector<ModelColorAdaptor*>& getColorAdaptors() const {
+			return data->getColorAdaptors();
+		}
 
-		ColorRGBA<float> ocol;
-		ColorRGBA<float> ecol;
+		const std::vector<ModelTransparencyAdaptor*>& getTransparencyAdaptors() const {
+			return data->getTransparencyAdaptors();
+		}
 
-		bool operator< (const ModelRenderPass& m) const
-		{
-			//TODO not sure if still used - remove if not.
-			// 
-			// This is the old sort order method which I'm pretty sure is wrong - need to try something else.
-			// Althogh transparent part should be displayed later, but don't know how to sort it
-			// And it will sort by geoset id now.
-			return geosetIndex < m.geosetIndex;
+		const std::vector<ModelBoneAdaptor*>& getBoneAdaptors() const {
+			return reinterpret_cast<const std::vector<ModelBoneAdaptor*>&>(boneAdaptors);
 		}
-	};
 
+		const std::vector<int16_t>& getKeyBoneLookup() const {
+			return data->getKeyBoneLookup();
+		}
 
+		const std::vector<ModelRibbonEmitterAdaptor*>& getRibbonAdaptors() const {
+			return reinterpret_cast<const std::vector<ModelRibbonEmitterAdaptor*>&>(ribbonAdaptors);
+		}
 
-	class M2Model : public M2Data {
-	public:
+		const std::vector<ModelParticleEmitterAdaptor*>& getParticleAdaptors() const {
+			return reinterpret_cast<const std::vector<ModelParticleEmitterAdaptor*>&>(particleAdaptors);
+		}
 
-		using make_result_t = std::pair<std::unique_ptr<M2Model>, std::vector<TextureLoadDef>>;
-		using Factory = std::function<make_result_t(GameFileSystem*, const GameFileUri&)>;
+		const std::vector<ModelAttachmentDefinitionAdaptor*>& getAttachmentDefintionAdaptors() const {
+			return data->getAttachmentDefintionAdaptors();
+		}
+
+		const std::vector<uint32_t>& getGlobalSequences() const {
+			return data->getGlobalSequences();
+		}
 
-		static make_result_t make(GameFileSystem* fs, const GameFileUri& uri) {
-			std::unique_ptr<M2Model> m2 = std::make_unique<M2Model>();
+		const std::vector<Vector3>& getVertices() const {
+			return data->getVertices();
+		}
 
-			M2Loader loader(m2.get(), fs, uri);
-			m2->modelPathInfo =  ModelPathInfo(m2->getFileInfo().path, fs);	
-			m2->renderPasses = std::move(loader.renderPasses);
+		const std::vector<Vector3>& getNormals() const {
+			return data->getNormals();
+		}
 
-			return std::make_pair(std::move(m2), std::move(loader.textures));
+		const std::vector<uint16_t>& getIndices() const {
+			return data->getIndices();
 		}
 
+		const std::vector<Vector2>& getTextureCoords() const {
+			return data->getTextureCoords();
+		}
 
-		const ModelPathInfo& getModelPathInfo() const {
-			return modelPathInfo;
+		const std::vector<Vector3>& getBounds() const {
+			return data->getBounds();
 		}
 
-		const std::vector<ModelRenderPass>& getRenderPasses() const {
-			return renderPasses;
+		const std::vector<uint16_t>& getBoundTriangles() const {
+			return data->getBoundTriangles();
+		}
+
+		const std::vector<ModelVertexM2>& getRawVertices() const {
+			return data->getRawVertices();
+		}
+
+		const std::vector<ModelTextureM2>& getTextureDefinitions() const {
+			return data->getTextureDefinitions();
+		}
+
+		const std::vector<uint16_t>& getAttachmentLookups() const {
+			return data->getAttachmentLookups();
+		}
+
+		void loadAnimation(size_t animation_index) const {
+			data->loadAnimation(animation_index);
 		}
 
 		void updateParticles(size_t animation_index, const AnimationTickArgs& tick) {
@@ -369,50 +505,50 @@ namespace core {
 		}
 
 		void calculateBones(size_t animation_index, const AnimationTickArgs& tick) {
+			loadAnimation(animation_index);
 
-			const auto keybone_lookup_size = keyBoneLookup.size();
-			const auto bone_adaptor_size = boneAdaptors.size();
-
-			if (bone_adaptor_size == 0) {
-				return;
+			if (boneEvaluator) {
+				boneEvaluator->calculate(animation_index, tick);
 			}
+		}
 
-			for (auto& bone : boneAdaptors) {
-				bone->resetCalculated();
-			}
+	protected:
+		std::shared_ptr<const M2Data> data;
 
-			//TODO check if char different logic?
-			if (keybone_lookup_size > KeyBones::BONE_ROOT) {
-				const auto keybone_val = keyBoneLookup.at(KeyBones::BONE_ROOT);
-				for (auto i = 0; i < keybone_val; i++) {
-					boneAdaptors[i]->calculateMatrix(animation_index, tick, reinterpret_cast<std::vector<ModelBoneAdaptor*>&>(boneAdaptors));
-				}
-
-				const int32_t upper = std::ranges::min({
-					(int32_t)KeyBones::BONE_MAX,
-					(int32_t)(keybone_lookup_size - 1),
-					(int32_t)(bone_adaptor_size - 1)
-					});
-
-				for (int32_t i = KeyBones::BONE_ROOT; i < upper; i++) {
-					const auto keybone_val = keyBoneLookup.at(i);
-					if (keybone_val >= 0) {
-						boneAdaptors[i]->calculateMatrix(animation_index, tick, reinterpret_cast<std::vector<ModelBoneAdaptor*>&>(boneAdaptors));
-					}
-				}
-			}
+		std::vector<std::unique_ptr<ModelBoneAdaptor>> boneAdaptors;
+		std::unique_ptr<ModelBoneEvaluator> boneEvaluator;
+		std::vector<std::unique_ptr<ModelRibbonEmitterAdaptor>> ribbonAdaptors;
+		std::vector<std::unique_ptr<ModelParticleEmitterAdaptor>> particleAdaptors;
+	};
 
-			for (auto& bone : boneAdaptors) {
-				bone->calculateMatrix(animation_index, tick, reinterpret_cast<std::vector<ModelBoneAdaptor*>&>(boneAdaptors));
-			}
-		}
+	/// <summary>
+	/// Parsed models which are still in use by at least one M2Model, so further instances of the same file skip loading.
+	/// Thread safe, entries are released along with the last instance using them.
+	/// </summary>
+	class M2DataCache {
+	public:
+		M2DataCache() = default;
+		M2DataCache(M2DataCache&&) = delete;
+		virtual ~M2DataCache() {}
+
+		std::shared_ptr<const M2Data> get(GameFileSystem* fs, const GameFileUri& uri);
+
+		// detaches every model still in use which was loaded from the file system and drops their entries, must be called before the file system is destroyed.
+		// models already in the scene keep their data, later loads parse the file again.
+		void release(const GameFileSystem* fs);
+
+		// cache used by M2Model::make
+		static M2DataCache& global();
 
 	protected:
-		std::vector<ModelRenderPass> renderPasses;
+		// file ids are used when known, otherwise the normalised path.
+		using key_t = std::tuple<const GameFileSystem*, GameFileUri::id_t, GameFileUri::path_t>;
 
-	private:
-		ModelPathInfo modelPathInfo;
-	};
+		std::mutex mutex;
+		std::map<key_t, std::weak_ptr<const M2Data>> entries;
 
+		// models which couldnt be keyed, only tracked so they can be released.
+		std::vector<std::pair<const GameFileSystem*, std::weak_ptr<const M2Data>>> unshared;
+	};
 
 }
\ No newline at end of file
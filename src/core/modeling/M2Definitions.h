@@ -148,7 +148,8 @@ namespace core {
 
 			//TODO need to be able to detect if file is chunked or not ahead of time, to avoid back chunks.
 			std::map<M2Signature, Chunk> result;
-			size_t to_read = file->getFileSize();
+			const auto buffer = file->data();
+			size_t to_read = buffer.size();
 			size_t offset = 0;
 			struct {
 				M2Signature id;
@@ -156,7 +157,7 @@ namespace core {
 			} header;
 
 			while (to_read > sizeof(header)) {
-				file->read(&header, sizeof(header), offset);
+				memcpy(&header, buffer.data() + offset, sizeof(header));
 
 				if (signatureCompare(header.id, NULL_SIG)) {
 					break;
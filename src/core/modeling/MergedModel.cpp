@@ -49,10 +49,16 @@ namespace core {
 			}
 			bone_index++;
 		}
+
+		invalidatePose();
 	}
 
 	void MergedModel::update(const Animator& animator, const AnimationTickArgs& tick)
 	{
+		if (!updatePoseRevision(animator)) {
+			return;
+		}
+
 		model->calculateBones(animator.getAnimationIndex().value(), tick);
 
 		//updateAnimation(model.get());
@@ -70,32 +76,14 @@ namespace core {
 			return;
 		}
 
-		auto index = 0;
-		for (auto& orgVert : model->getRawVertices()) {
-			Vector3 v = Vector3(0, 0, 0);
-			Vector3 n = Vector3(0, 0, 0);
-
-			for (size_t b = 0; b < ModelVertexM2::BONE_COUNT; b++)
-			{
-				if (orgVert.boneWeights[b] > 0) {
-					const auto bone_index = orgVert.bones[b];
-					const ModelBoneAdaptor* adaptor = boneAdaptors[bone_index];
-
-					if (boneMap.contains(bone_index)) {
-						const auto mapped_index = boneMap[bone_index];
-						adaptor = owner->model->getBoneAdaptors().at(mapped_index);
-					}
-
-					Vector3 tv = adaptor->getMat() * precomputed[index].position;
-					Vector3 tn = adaptor->getMRot() * precomputed[index].normal;
-					v += tv * ((float)orgVert.boneWeights[b] / 255.0f);
-					n += tn * ((float)orgVert.boneWeights[b] / 255.0f);
-				}
+		// substitute the related owner bones, then skin as normal.
+		std::vector<const ModelBoneAdaptor*> bones(boneAdaptors.begin(), boneAdaptors.end());
+		for (const auto& [bone_index, owner_bone_index] : boneMap) {
+			if (bone_index < bones.size()) {
+				bones[bone_index] = owner->model->getBoneAdaptors().at(owner_bone_index);
 			}
-
-			animatedVertices[index] = v;
-			animatedNormals[index] = n;
-			index++;
 		}
+
+		skinning.update(bones, animatedVertices, animatedNormals);
 	}
 };
\ No newline at end of file
@@ -50,14 +50,8 @@ namespace core {
 
 	void Model::update(uint32_t delta_time_msecs)
 	{
-		if (animate && animator.getAnimationId().has_value()) {
-			const AnimationTickArgs& tick = animator.tick(delta_time_msecs);
-
-			model->calculateBones(animator.getAnimationIndex().value(), tick);
-			updateAnimation();
-
-			model->updateParticles(animator.getAnimationIndex().value(), tick);
-			model->updateRibbons(animator.getAnimationIndex().value(), tick);
+		if (updateSelf(delta_time_msecs)) {
+			const AnimationTickArgs& tick = animator.getLastTick();
 
 			for (auto& child : attachments) {
 				child->update(animator, tick);
@@ -69,6 +63,26 @@ namespace core {
 		}
 	}
 
+	bool Model::updateSelf(uint32_t delta_time_msecs)
+	{
+		if (animate && animator.getAnimationId().has_value()) {
+			const AnimationTickArgs& tick = animator.tick(delta_time_msecs);
+
+			// children track their own pose, so may still need updating when this one is current.
+			if (updatePoseRevision(animator)) {
+				model->calculateBones(animator.getAnimationIndex().value(), tick);
+				updateAnimation();
+
+				model->updateParticles(animator.getAnimationIndex().value(), tick);
+				model->updateRibbons(animator.getAnimationIndex().value(), tick);
+			}
+
+			return true;
+		}
+
+		return false;
+	}
+
 	void ModelHelper::addItem(CharacterSlot slot, const core::CharacterItemWrapper& wrapper, std::function<void(Attachment*, uint32_t)> visual_handler) {
 		assert(_attach_provider != nullptr);
 		//TODO only update if needed - currenlty item gets removed and re-added even if no changes are needed.
@@ -85,19 +99,41 @@ namespace core {
 		assert(item_models.size() >= attach_positions.size());
 		assert(item_textures.size() >= attach_positions.size());
 
+		auto resolve_model_path = [&](size_t index) -> GameFileUri {
+			GameFileUri model_path = item_models[index];
+			if (model_path.isPath()) {
+				model_path = GameFileUri::replaceExtension(model_path.getPath(), "m2");
+			}
+			return model_path;
+		};
+
+		// request every model and texture for the item up front, so the files load concurrently rather than one attachment at a time.
+		auto prefetched = [&]() -> std::future<void> {
+			std::vector<GameFileUri> files;
+			for (size_t i = 0; i < attach_positions.size(); i++) {
+				const auto model_path = resolve_model_path(i);
+				if (model_path.isEmpty()) {
+					continue;
+				}
+
+				files.push_back(model_path);
+				if (!item_textures[i].isEmpty()) {
+					files.push_back(item_textures[i]);
+				}
+			}
+
+			return _attach_provider->prefetch(files);
+		}();
+
 		for (auto attach_pos : attach_positions) {
 
-			GameFileUri model_path = item_models[attachment_index];
+			GameFileUri model_path = resolve_model_path(attachment_index);
 			GameFileUri texture_path = item_textures[attachment_index];
 
 			if (model_path.isEmpty()) {
 				continue;
 			}
 
-			if (model_path.isPath()) {
-				model_path = GameFileUri::replaceExtension(model_path.getPath(), "m2");
-			}
-
 			try {
 
 				Log::message("Loaded attachment model: " + model_path.toString());
@@ -136,8 +136,10 @@ namespace core {
 
 		void update(uint32_t delta_time_msecs);
 
+		// advances the animation and updates this model only, returns true if the attachments and merged models also need updating.
+		// used by Scene::update, which updates the children separately.
+		bool updateSelf(uint32_t delta_time_msecs);
 
-		
 
 		std::unique_ptr<M2Model> model;
 		TextureSet textureSet;
@@ -1,6 +1,7 @@
 #pragma once
 #include <cstdint>
 #include <vector>
+#include <memory>
 #include "../utility/Vector3.h"
 #include "../utility/Vector2.h"
 #include "../utility/Matrix.h"
@@ -44,6 +45,9 @@ namespace core {
 		constexpr virtual uint16_t getId() const = 0;
 		constexpr virtual uint16_t getVariationId() const = 0;
 		constexpr virtual uint32_t getDuration() const = 0;
+		constexpr virtual uint32_t getFlags() const = 0;
+		// index of the next variation of the animation, or -1.
+		constexpr virtual int16_t getNextVariationIndex() const = 0;
 	};
 
 	class ModelTextureAnimationAdaptor {
@@ -91,9 +95,13 @@ namespace core {
 	class ModelBoneAdaptor {
 	public:
 		ModelBoneAdaptor() = default;
+		ModelBoneAdaptor(const ModelBoneAdaptor&) = default;
 		ModelBoneAdaptor(ModelBoneAdaptor&&) = default;
 		virtual ~ModelBoneAdaptor() {}
 
+		// copy for another instance of the model, animation data is shared.
+		virtual std::unique_ptr<ModelBoneAdaptor> clone() const = 0;
+
 		virtual const IAnimatedValue<Vector3>* getTranslation() const = 0;
 		virtual const IAnimatedValue<Quaternion>* getRotation() const = 0;
 		virtual const IAnimatedValue<Vector3>* getScale() const = 0;
@@ -111,6 +119,21 @@ namespace core {
 		virtual void resetCalculated() = 0;
 	};
 
+	/// <summary>
+	/// Calculates the matrices of every bone belonging to a model in a single pass.
+	/// </summary>
+	class ModelBoneEvaluator {
+	public:
+		ModelBoneEvaluator() = default;
+		ModelBoneEvaluator(ModelBoneEvaluator&&) = default;
+		virtual ~ModelBoneEvaluator() {}
+
+		virtual void calculate(size_t animation_index, const AnimationTickArgs& tick) = 0;
+
+		// evaluator for a clone of the same bones.
+		virtual std::unique_ptr<ModelBoneEvaluator> bind(const std::vector<std::unique_ptr<ModelBoneAdaptor>>& bone_adaptors) const = 0;
+	};
+
 
 	class ModelRibbonEmitterAdaptor {
 	public:
@@ -123,9 +146,12 @@ namespace core {
 		};
 
 		ModelRibbonEmitterAdaptor() = default;
+		ModelRibbonEmitterAdaptor(const ModelRibbonEmitterAdaptor&) = default;
 		ModelRibbonEmitterAdaptor(ModelRibbonEmitterAdaptor&&) = default;
 		virtual ~ModelRibbonEmitterAdaptor() {}
 
+		virtual std::unique_ptr<ModelRibbonEmitterAdaptor> clone() const = 0;
+
 		virtual void update(size_t animation_index, const AnimationTickArgs& tick, std::vector<ModelBoneAdaptor*>& allbones) = 0;
 
 		virtual const std::vector<uint16_t> getTexture() const = 0;
@@ -160,9 +186,12 @@ namespace core {
 		};
 
 		ModelParticleEmitterAdaptor() = default;
+		ModelParticleEmitterAdaptor(const ModelParticleEmitterAdaptor&) = default;
 		ModelParticleEmitterAdaptor(ModelParticleEmitterAdaptor&&) = default;
 		virtual ~ModelParticleEmitterAdaptor() {}
 
+		virtual std::unique_ptr<ModelParticleEmitterAdaptor> clone() const = 0;
+
 		virtual const std::vector<TexCoordSet>& getTiles() const = 0;
 
 		virtual const std::list<Particle>& getParticles() const = 0;
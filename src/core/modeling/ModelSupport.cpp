@@ -28,52 +28,28 @@ namespace core {
 
 	void ModelAnimationInfo::initAnimationData(const M2Model* _model) {
 		model = _model;
-		animatedVertices.clear();
-		animatedNormals.clear();
-		precomputed.clear();
+		poseRevision.reset();
+		skinned = model->getBoneAdaptors().size() > 0;
 
-		animatedVertices = model->getVertices();
-		animatedNormals = model->getNormals();
-
-		const auto& orgVerts = model->getRawVertices();
-		precomputed.reserve(orgVerts.size());
-
-		for (const auto& orgVert : orgVerts) {
-			precomputed.emplace_back(
-				Vector3::yUpToZUp(orgVert.position),
-				Vector3::yUpToZUp(orgVert.normal).normalize()
-			);
+		if (skinned) {
+			animatedVertices = model->getVertices();
+			animatedNormals = model->getNormals();
+			skinning.init(model->getRawVertices(), model->getBoneAdaptors().size());
+		}
+		else {
+			animatedVertices = {};
+			animatedNormals = {};
+			skinning = VertexSkinning();
 		}
 	}
 
 	void ModelAnimationInfo::updateAnimation() {
 
-		const auto& boneAdaptors = model->getBoneAdaptors();
-
-		if (boneAdaptors.size() == 0) {
+		if (!skinned) {
 			return;
 		}
 
-		auto index = 0;
-		for (auto& orgVert : model->getRawVertices()) {
-			Vector3 v = Vector3(0, 0, 0);
-			Vector3 n = Vector3(0, 0, 0);
-
-			for (size_t b = 0; b < ModelVertexM2::BONE_COUNT; b++)
-			{
-				if (orgVert.boneWeights[b] > 0) {
-					const auto& adaptor = boneAdaptors[orgVert.bones[b]];
-					Vector3 tv = adaptor->getMat() * precomputed[index].position; 
-					Vector3 tn = adaptor->getMRot() * precomputed[index].normal;
-					v += tv * ((float)orgVert.boneWeights[b] / 255.0f);
-					n += tn * ((float)orgVert.boneWeights[b] / 255.0f);
-				}
-			}
-
-			animatedVertices[index] = v;
-			animatedNormals[index] = n;
-			index++;
-		}
+		skinning.update(model->getBoneAdaptors(), animatedVertices, animatedNormals);
 	}
 
 	void ModelGeosetInfo::initGeosetData(const M2Model* _model, bool default_vis) {
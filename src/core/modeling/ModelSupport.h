@@ -11,6 +11,8 @@
 #include "../database/GameDatasetAdaptors.h"
 #include "../modeling/M2.h"
 #include "../modeling/Geoset.h"
+#include "../modeling/VertexSkinning.h"
+#include "../modeling/Animator.h"
 
 namespace core {
 
@@ -88,21 +90,41 @@ namespace core {
 		ModelAnimationInfo(ModelAnimationInfo&&) = default;
 		virtual ~ModelAnimationInfo() {}
 
-		std::vector<Vector3> animatedVertices;
-		std::vector<Vector3> animatedNormals;
-
 		void initAnimationData(const M2Model* model);
 
 		void updateAnimation();
 
+		// returns false if the pose is already current for the animator, otherwise records the animator revision and returns true.
+		bool updatePoseRevision(const Animator& animator) {
+			if (poseRevision == animator.getRevision()) {
+				return false;
+			}
+
+			poseRevision = animator.getRevision();
+			return true;
+		}
+
+		// forces the pose to be recalculated on the next update.
+		void invalidatePose() {
+			poseRevision.reset();
+		}
+
+		// models without bones are never skinned, the static model data is used directly.
+		const std::vector<Vector3>& getAnimatedVertices() const {
+			return skinned ? animatedVertices : model->getVertices();
+		}
+
+		const std::vector<Vector3>& getAnimatedNormals() const {
+			return skinned ? animatedNormals : model->getNormals();
+		}
+
 	protected:
-		struct VertData {
-			Vector3 position;
-			Vector3 normal;
-		};
+		std::vector<Vector3> animatedVertices;
+		std::vector<Vector3> animatedNormals;
 
-		//purely for speed, we convert the data from raw format and store for use.
-		std::vector<VertData> precomputed;
+		VertexSkinning skinning;
+		bool skinned = false;
+		std::optional<uint64_t> poseRevision;
 	private:
 		const M2Model* model;
 	};
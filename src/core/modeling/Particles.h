@@ -8,7 +8,8 @@
 namespace core {
 
 //TODO remove static variable -  probably needs to be moved into the emitter classes? looks like it needs to be kept between calls
-	static Matrix	SpreadMat;
+	// thread local, particle emitters of different models are updated concurrently.
+	static thread_local Matrix	SpreadMat;
 	void CalcSpreadMatrix(float Spread1, float Spread2, float w, float l);
 
 
@@ -1,5 +1,7 @@
 #include "../../stdafx.h"
 #include "Scene.h"
+#include <QtConcurrent>
+#include <numeric>
 
 namespace core {
 
@@ -24,6 +26,55 @@ namespace core {
 		return last;
 	}
 
+	void Scene::update(uint32_t delta_time_msecs) {
+		if (models.size() == 0) {
+			return;
+		}
+
+		// models are independent of each other, children depend only on their owners bones.
+		std::vector<Model*> animating;
+		animating.reserve(models.size());
+
+		{
+			std::vector<uint8_t> updated(models.size(), false);
+			std::vector<size_t> indexes(models.size());
+			std::iota(indexes.begin(), indexes.end(), 0);
+
+			QtConcurrent::blockingMap(indexes, [&](size_t index) {
+				updated[index] = models[index]->updateSelf(delta_time_msecs);
+			});
+
+			for (size_t i = 0; i < models.size(); i++) {
+				if (updated[i]) {
+					animating.push_back(models[i].get());
+				}
+			}
+		}
+
+		std::vector<std::function<void()>> children;
+
+		for (auto* model : animating) {
+			const Animator& animator = model->animator;
+			const AnimationTickArgs& tick = animator.getLastTick();
+
+			for (auto* attachment : model->getAttachments()) {
+				children.push_back([attachment, &animator, &tick]() {
+					attachment->update(animator, tick);
+				});
+			}
+
+			for (auto* merged : model->getMerged()) {
+				children.push_back([merged, &animator, &tick]() {
+					merged->update(animator, tick);
+				});
+			}
+		}
+
+		QtConcurrent::blockingMap(children, [](const std::function<void()>& task) {
+			task();
+		});
+	}
+
 	ComponentMeta* Scene::addComponent(ComponentMeta* meta)
 	{
 		emit componentAdded(meta);
@@ -25,6 +25,12 @@ namespace core {
 		ComponentMeta* addComponent(ComponentMeta* meta);
 		void removeComponent(ComponentMeta* meta);
 
+		/// <summary>
+		/// Advance and update the animation of every model.
+		/// Models are updated concurrently, followed by their attachments and merged models, returns once all updates are complete.
+		/// </summary>
+		void update(uint32_t delta_time_msecs);
+
 		std::vector<std::unique_ptr<Model>> models;
 		TextureManager textureManager;
 
@@ -1,7 +1,7 @@
 #pragma once
 #include "ModelSupport.h"
 #include "../filesystem/GameFileSystem.h"
-#include "../filesystem/CascFileSystem.h"
+#include "../filesystem/GameFileSystem.h"
 #include <unordered_set>
 #include <WDBReader/Database/DB2File.hpp>
 #include "../database/WDBDefsGameDatabase.h"
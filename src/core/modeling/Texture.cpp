@@ -4,20 +4,102 @@
 #include "../utility/Logger.h"
 #include "../utility/Exceptions.h"
 #include "../utility/ScopeGuard.h"
-
-#include "../../ddslib.h"
+#include "BlockDecoder.h"
 
 #include <QImage>
 #include <QPoint>
+#include <QtConcurrent>
+#include <QThreadPool>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
 
 namespace core {
 
+	namespace {
+
+		// approximate number of pixels decoded by each task, smaller images are decoded without splitting.
+		constexpr size_t DECODE_TASK_PIXELS = 256 * 256;
+
+		// splits 'rows' rows of 'row_pixels' each into tasks of roughly DECODE_TASK_PIXELS.
+		template<typename fn>
+		void addRowTasks(uint32_t rows, size_t row_pixels, std::vector<std::function<void()>>& tasks, fn decode_rows) {
+			const uint32_t rows_per_task = (uint32_t)std::max<size_t>(1, DECODE_TASK_PIXELS / std::max<size_t>(1, row_pixels));
+			for (uint32_t begin = 0; begin < rows; begin += rows_per_task) {
+				const uint32_t end = std::min(rows, begin + rows_per_task);
+				tasks.push_back([decode_rows, begin, end]() {
+					decode_rows(begin, end);
+				});
+			}
+		}
+
+		struct DXTFormat {
+			GLint glFormat;
+			BlockDecoder::Format blockFormat;
+		};
+
+		//TODO CHECK LOGIC!
+		DXTFormat dxtFormat(const BLPHeader& header) {
+			if (header.alphaSize == 8 && header.preferredFormat == 7) {
+				return { GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, BlockDecoder::Format::BC3 };
+			}
+
+			if (header.alphaSize == 8 || header.alphaSize == 4) {
+				return { GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, BlockDecoder::Format::BC2 };
+			}
+
+			return { GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, BlockDecoder::Format::BC1 };
+		}
+
+		std::optional<BlockDecoder::Format> blockFormat(GLint gl_format) {
+			switch (gl_format) {
+			case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+			case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+				return BlockDecoder::Format::BC1;
+			case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+				return BlockDecoder::Format::BC2;
+			case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+				return BlockDecoder::Format::BC3;
+			default:
+				return std::nullopt;
+			}
+		}
+
+		void decodePaletteRows(const BLPHeader& header, const uint32_t* palette, std::span<const uint8_t> mip, uint32_t w, uint32_t h, uint32_t row_begin, uint32_t row_end, uint32_t* out) {
+			const uint8_t* indices = mip.data();
+			const uint8_t* alphas = mip.data() + (size_t)w * h;
+
+			for (uint32_t y = row_begin; y < row_end; y++) {
+				for (uint32_t x = 0; x < w; x++) {
+					const size_t i = (size_t)y * w + x;
+
+					uint32_t k = palette[indices[i]];
+					k = ((k & 0x00FF0000) >> 16) | ((k & 0x0000FF00)) | ((k & 0x000000FF) << 16);
+
+					uint32_t alpha = 0xff;
+					if (header.alphaSize == 8) {
+						alpha = alphas[i];
+					}
+					else if (header.alphaSize == 4) {
+						alpha = ((alphas[i / 2] >> ((i % 2) * 4)) & 0xf) * 0x11;
+					}
+					else if (header.alphaSize == 1) {
+						alpha = (alphas[i / 8] & (1 << (i % 8))) ? 0xff : 0;
+					}
+
+					out[i] = k | (alpha << 24);
+				}
+			}
+		}
+	}
+
 	BLPLoader::BLPLoader(ArchiveFile* file) :source(file) {
-		auto size = file->getFileSize();
-		if (size < sizeof(header)) {
+		// header and mips are all views over the same buffer, the file is only read once.
+		buffer = file->data();
+		if (buffer.size() < sizeof(header)) {
 			throw FileIOException("File is smaller than BLP header.");
 		}
-		file->read(&header, sizeof(header));
+		memcpy(&header, buffer.data(), sizeof(header));
 
 		std::string signature((char*)header.signature, sizeof(header.signature));
 		if (signature != "BLP2") {
@@ -30,155 +112,127 @@ namespace core {
 		return header;
 	}
 
-	void BLPLoader::load(int32_t mip_count, callback_t fn) {
-		bool video_support_compression = false; //TODO detect / config
+	std::span<const uint8_t> BLPLoader::mipData(int32_t mip_index, size_t required_size) const {
+		//mips offset already include the header size.
+		const size_t offset = header.mipOffsets[mip_index];
+		const size_t size = header.mipSizes[mip_index];
 
-		auto bufferSize = source->getFileSize();
-		auto buffer = std::vector<uint8_t>(bufferSize);
-		source->read(buffer.data(), bufferSize);
+		if (offset == 0 || size == 0 || size < required_size || offset + required_size > buffer.size()) {
+			return {};
+		}
+
+		return buffer.subspan(offset, std::min(size, buffer.size() - offset));
+	}
+
+	bool BLPLoader::loadCompressed(compressed_callback_t fn) {
+		if (header.colorEncoding != BLPColorEncoding::COLOR_DXT) {
+			return false;
+		}
+
+		const auto format = dxtFormat(header);
+		const int32_t mip_count = header.hasMips > 0 ? 16 : 1;
 
 		uint32_t w = header.width;
 		uint32_t h = header.height;
 
-		switch (header.colorEncoding) {
-		case BLPColorEncoding::COLOR_PALETTE:
-		{
-			std::span<uint32_t> pal_view((uint32_t*)(buffer.data() + sizeof(BLPHeader)), sizeof(uint32_t) * 256);
+		for (auto i = 0; i < mip_count; i++) {
+			if (w == 0) w = 1;
+			if (h == 0) h = 1;
 
-			bool has_alpha = header.alphaSize != 0;
+			const auto size = BlockDecoder::compressedSize(format.blockFormat, w, h);
+			const auto data = mipData(i, size);
+			if (data.empty()) {
+				break;
+			}
 
-			//TODO CHECK LOGIC
-			for (auto i = 0; i < mip_count; i++) {
-				if (w == 0) w = 1;
-				if (h == 0) h = 1;
+			fn(i, w, h, format.glFormat, data.first(size));
 
-				auto out_buffer = std::vector<uint32_t>(header.width * header.height);
+			w >>= 1;
+			h >>= 1;
+		}
 
-				if (header.mipOffsets[i] && header.mipSizes[i]) {
-					std::span<uint8_t> buffer_view((uint8_t*)(buffer.data() + header.mipOffsets[i]), header.mipSizes[i]);
+		return true;
+	}
 
-					int alpha = 0;
-					auto buffer_index = 0;
+	void BLPLoader::load(int32_t mip_count, callback_t fn) {
+		auto mips = decodeMips(mip_count);
 
-					std::span<uint8_t> alpha_view;
-					auto alpha_index = 0;
-					if (header.alphaSize > 0) {
-						alpha_view = std::span((uint8_t*)(buffer_view.data() + (w * h)), header.mipSizes[i] - (w * h));
-					}
+		for (size_t i = 0; i < mips.size(); i++) {
+			fn((int32_t)i, mips[i].width, mips[i].height, mips[i].data.data());
+		}
+	}
 
-					uint8_t alpha_sub_offset = 0;
-
-					for (uint32_t y = 0; y < h; y++) {
-						for (uint32_t x = 0; x < w; x++) {
-
-							uint32_t k = pal_view[buffer_view[buffer_index]];
-
-							k = ((k & 0x00FF0000) >> 16) | ((k & 0x0000FF00)) | ((k & 0x000000FF) << 16);
-
-							if (has_alpha) {
-								if (header.alphaSize == 8) {
-									alpha = alpha_view[alpha_index++];
-								}
-								else if (header.alphaSize == 4) {
-									alpha = (alpha_view[alpha_index] & (0xf << alpha_sub_offset++)) * 0x11;
-									if (alpha_sub_offset == 2)
-									{
-										alpha_sub_offset = 0;
-										alpha_index++;
-									}
-								}
-								else if (header.alphaSize == 1) {
-									alpha = (alpha_view[alpha_index] & (1 << alpha_sub_offset++)) ? 0xff : 0;
-									if (alpha_sub_offset == 8)
-									{
-										alpha_sub_offset = 0;
-										alpha_index++;
-									}
-								}
-							}
-							else {
-								alpha = 0xff;
-							}
-
-							k |= alpha << 24;
-							out_buffer[buffer_index] = k;
-							buffer_index++;
-
-						}
-					}
+	std::vector<DecodedTexture::Mip> BLPLoader::decodeMips(int32_t mip_count, QThreadPool* pool) {
+		struct MipLevel {
+			uint32_t width;
+			uint32_t height;
+			std::span<const uint8_t> data;
+			std::vector<uint8_t> pixels;
+		};
 
-					fn(i, w, h, out_buffer.data());
-				}
-				else {
+		// the chain ends at the first missing mip.
+		std::vector<MipLevel> mips;
+		mips.reserve(mip_count);
+
+		const auto collect_mips = [&](auto required_size) {
+			uint32_t w = header.width;
+			uint32_t h = header.height;
+
+			for (auto i = 0; i < mip_count; i++) {
+				if (w == 0) w = 1;
+				if (h == 0) h = 1;
+
+				const auto data = mipData(i, required_size(w, h));
+				if (data.empty()) {
 					break;
 				}
 
+				mips.push_back({ w, h, data, {} });
+
 				w >>= 1;
 				h >>= 1;
 			}
-		}
-		break;
-		case BLPColorEncoding::COLOR_DXT:
-		{
-			GLint format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
-			int32_t blockSize = 8;
-
-			//TODO CHECK LOGIC!
+		};
 
-			if (header.alphaSize == 8 || header.alphaSize == 4) {
-				format = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
-				blockSize = 16;
-			}
+		std::vector<std::function<void()>> tasks;
 
-			if (header.alphaSize == 8 && header.preferredFormat == 7) {
-				format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
-				blockSize = 16;
+		switch (header.colorEncoding) {
+		case BLPColorEncoding::COLOR_PALETTE:
+		{
+			if (buffer.size() < sizeof(BLPHeader) + sizeof(uint32_t) * 256) {
+				break;
 			}
 
-			auto uncompressed_buffer = std::vector<uint8_t>();
+			const uint32_t* palette = (const uint32_t*)(buffer.data() + sizeof(BLPHeader));
 
-			if (!video_support_compression) {
-				uncompressed_buffer.resize(header.width * header.height * 4);
-			}
+			collect_mips([&](uint32_t w, uint32_t h) {
+				const size_t pixels = (size_t)w * h;
+				return pixels + (pixels * header.alphaSize + 7) / 8;
+			});
 
-			for (auto i = 0; i < mip_count; i++) {
-				if (w == 0) w = 1;
-				if (h == 0) h = 1;
+			for (auto& mip : mips) {
+				mip.pixels.resize((size_t)mip.width * mip.height * 4);
 
-				if (header.mipOffsets[i] && header.mipSizes[i]) {
+				addRowTasks(mip.height, mip.width, tasks, [this, palette, &mip](uint32_t begin, uint32_t end) {
+					decodePaletteRows(header, palette, mip.data, mip.width, mip.height, begin, end, (uint32_t*)mip.pixels.data());
+				});
+			}
+		}
+		break;
+		case BLPColorEncoding::COLOR_DXT:
+		{
+			const auto block_format = dxtFormat(header).blockFormat;
 
-					//mips offset already include the header size.
-					std::span<uint8_t> buffer_view((uint8_t*)(buffer.data() + header.mipOffsets[i]), header.mipSizes[i]);
+			collect_mips([block_format](uint32_t w, uint32_t h) {
+				return BlockDecoder::compressedSize(block_format, w, h);
+			});
 
-					int tmp_size = ((w + 3) / 4) * ((h + 3) / 4) * blockSize;
-					if (video_support_compression) {
-						glCompressedTexImage2DARB(GL_TEXTURE_2D, (GLint)i, format, w, h, 0, tmp_size, buffer_view.data());
-					}
-					else {
-						switch (format) {
-						case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
-							DDSDecompressDXT1(buffer_view.data(), w, h, uncompressed_buffer.data());
-							break;
-						case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
-							DDSDecompressDXT3(buffer_view.data(), w, h, uncompressed_buffer.data());
-							break;
-						case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
-							DDSDecompressDXT5(buffer_view.data(), w, h, uncompressed_buffer.data());
-							break;
-
-						default:
-							assert(false);
-						}
-
-						fn(i, w, h, uncompressed_buffer.data());
-					}
-				}
-				else {
-					break;
-				}
+			for (auto& mip : mips) {
+				mip.pixels.resize((size_t)mip.width * mip.height * 4);
 
-				w >>= 1;
-				h >>= 1;
+				addRowTasks(BlockDecoder::blockCount(mip.height), (size_t)mip.width * 4, tasks, [block_format, &mip](uint32_t begin, uint32_t end) {
+					BlockDecoder::decodeRows(block_format, mip.data, mip.width, mip.height, begin, end, mip.pixels.data());
+				});
 			}
 		}
 		break;
@@ -187,6 +241,30 @@ namespace core {
 			assert(false);
 			break;
 		}
+
+		if (tasks.size() > 1) {
+			const auto run = [](const std::function<void()>& task) {
+				task();
+			};
+
+			if (pool != nullptr) {
+				QtConcurrent::blockingMap(pool, tasks, run);
+			}
+			else {
+				QtConcurrent::blockingMap(tasks, run);
+			}
+		}
+		else if (tasks.size() == 1) {
+			tasks.front()();
+		}
+
+		std::vector<DecodedTexture::Mip> result;
+		result.reserve(mips.size());
+		for (auto& mip : mips) {
+			result.push_back({ mip.width, mip.height, std::move(mip.pixels) });
+		}
+
+		return result;
 	}
 
 	void BLPLoader::loadAll(callback_t fn) {
@@ -200,6 +278,24 @@ namespace core {
 		load(1, std::move(fn));
 	}
 
+	DecodedTexture BLPLoader::decode(bool keep_compressed, QThreadPool* pool) {
+		DecodedTexture result;
+		result.width = header.width;
+		result.height = header.height;
+		result.compressed = header.colorEncoding == BLPColorEncoding::COLOR_DXT;
+
+		const bool kept_compressed = keep_compressed && loadCompressed([&result](int32_t mip_index, uint32_t w, uint32_t h, GLint format, std::span<const uint8_t> blocks) {
+			result.compressedFormat = format;
+			result.mips.push_back({ w, h, std::vector<uint8_t>(blocks.begin(), blocks.end()) });
+		});
+
+		if (!kept_compressed) {
+			result.mips = decodeMips(header.hasMips > 0 ? 16 : 1, pool);
+		}
+
+		return result;
+	}
+
 	Texture::Texture(GameFileUri uri) {
 		this->fileUri = uri;
 		id = Texture::INVALID_ID;
@@ -209,27 +305,94 @@ namespace core {
 	}
 
 	std::vector<uint8_t> Texture::getPixels(uint32_t format) {
-		std::vector<uint8_t> buff;
-		buff.resize(width * height * 4);
+		return readPixels(id, format);
+	}
+
+	std::vector<uint8_t> Texture::readPixels(GLuint texture_id, uint32_t format) {
+		assert(format == GL_RGBA || format == GL_BGRA_EXT);
+
+		glBindTexture(GL_TEXTURE_2D, texture_id);
+
+		GLint width = 0, height = 0, compressed = GL_FALSE, internal_format = 0;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internal_format);
+
+		std::vector<uint8_t> buff((size_t)width * height * 4);
+
+		// compressed textures are decoded the same way as the cpu upload path, rather than relying on the driver.
+		const auto block_format = compressed == GL_TRUE ? blockFormat(internal_format) : std::nullopt;
+		if (block_format.has_value()) {
+			GLint compressed_size = 0;
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &compressed_size);
+
+			if ((size_t)compressed_size >= BlockDecoder::compressedSize(block_format.value(), width, height)) {
+				std::vector<uint8_t> blocks(compressed_size);
+				glGetCompressedTexImage(GL_TEXTURE_2D, 0, blocks.data());
+				BlockDecoder::decode(block_format.value(), blocks, width, height, buff.data());
+
+				if (format == GL_BGRA_EXT) {
+					for (size_t i = 0; i < buff.size(); i += 4) {
+						std::swap(buff[i], buff[i + 2]);
+					}
+				}
+
+				return buff;
+			}
+		}
 
-		glBindTexture(GL_TEXTURE_2D, id);
 		glGetTexImage(GL_TEXTURE_2D, 0, format, GL_UNSIGNED_BYTE, buff.data());
 
 		return buff;
 	}
 
+	struct TextureManager::UploadQueue {
+		struct Decoded {
+			std::weak_ptr<Texture> texture;
+			DecodedTexture data;
+		};
+
+		std::mutex mutex;
+		std::condition_variable changed;
+		std::deque<Decoded> ready;
+		size_t decoding = 0;
+
+		// separate from the global pool, so texture decoding doesnt hold up the scene update.
+		QThreadPool pool;
+	};
+
+	TextureManager::TextureManager() : queue(std::make_unique<UploadQueue>()) {
+		queue->pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+	}
+
+	TextureManager::TextureManager(TextureManager&&) = default;
+
+	TextureManager::~TextureManager() {
+		// workers only reference the queue, so it must outlive them.
+		if (queue != nullptr) {
+			queue->pool.waitForDone();
+		}
+	}
+
 	std::shared_ptr<Texture> TextureManager::add(GameFileUri uri, GameFileSystem* fs) {
 
-		for (auto it = textureMap.begin(); it != textureMap.end(); ++it) {
-			if (auto temp = it->second.lock()) {
-				if (temp->fileUri == uri) {
-					return temp;
+		const auto key = makeKey(fs, uri);
+
+		{
+			const auto it = textureCache.find(key);
+			if (it != textureCache.end()) {
+				if (auto existing = it->second.lock()) {
+					_stats.hits++;
+					return existing;
 				}
 			}
 		}
 
-		auto tex = std::shared_ptr<Texture>(new Texture(uri), [&](Texture* t) {
-			remove(t->id);
+		_stats.misses++;
+
+		auto tex = std::shared_ptr<Texture>(new Texture(uri), [this, key](Texture* t) {
+			remove(t->id, key);
 			delete t;
 		});
 
@@ -240,59 +403,209 @@ namespace core {
 		//// create new texture and put it in memory
 		glGenTextures(1, &tex->id);
 
-		loadBLP(tex.get(), fs);
-
-		if (tex->id != Texture::INVALID_ID) {
-			textureMap[tex->id] = tex;
-			return tex;
+		if (tex->id == Texture::INVALID_ID) {
+			Log::message("Unable to load texture: " + tex->fileUri.toString());
+			return nullptr;
 		}
 
-		Log::message("Unable to load texture: " + tex->fileUri.toString());
-		return nullptr;
+		// the id stays the same once the real image is uploaded, so models can use the texture straight away.
+		static const uint8_t placeholder[4] = { 0x80, 0x80, 0x80, 0xFF };
+		glBindTexture(GL_TEXTURE_2D, tex->id);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		tex->width = 1;
+		tex->height = 1;
+
+		textureMap[tex->id] = tex;
+		textureCache[key] = tex;
+		_stats.entries = textureCache.size();
+		waiting.push_back({ tex, uri, fs, key });
+		dispatchDecodes();
+
+		return tex;
 	}
 
-	void TextureManager::remove(GLuint id)
+	void TextureManager::remove(GLuint id, const key_t& key)
 	{
 		if (glIsTexture(id)) {
 			glDeleteTextures(1, &id);
 		}
 
 		textureMap.erase(id);
+
+		// the entry may already have been replaced by a newer load of the same file.
+		const auto it = textureCache.find(key);
+		if (it != textureCache.end() && it->second.expired()) {
+			textureCache.erase(it);
+			_stats.entries = textureCache.size();
+		}
 	}
 
+	TextureManager::key_t TextureManager::makeKey(GameFileSystem* fs, const GameFileUri& uri)
+	{
+		GameFileInfo info;
+		try {
+			info = fs->asInfo(uri);
+		}
+		catch (const std::exception&) {
+			// e.g MPQ filesystems cant resolve ids, the uri is used as-is.
+			if (uri.isId()) {
+				return key_t(uri.getId());
+			}
 
-	void TextureManager::loadBLP(Texture* tex, GameFileSystem* fs) {
+			info.path = uri.getPath();
+		}
 
-		glBindTexture(GL_TEXTURE_2D, tex->id);
+		if (info.id != 0) {
+			return key_t(info.id);
+		}
 
-		std::unique_ptr<ArchiveFile> file;
-		
+		return key_t(info.path.toLower());
+	}
+
+	size_t TextureManager::processUploads(std::chrono::microseconds budget) {
+		const auto deadline = std::chrono::steady_clock::now() + budget;
+		size_t uploaded = 0;
+
+		while (uploadNext()) {
+			uploaded++;
+			if (std::chrono::steady_clock::now() >= deadline) {
+				break;
+			}
+		}
+
+		dispatchDecodes();
+
+		return uploaded;
+	}
+
+	void TextureManager::finishUploads() {
+		while (true) {
+			dispatchDecodes();
+
+			{
+				std::unique_lock lock(queue->mutex);
+				queue->changed.wait(lock, [this]() {
+					return queue->ready.size() > 0 || queue->decoding == 0;
+				});
+
+				if (queue->ready.size() == 0 && waiting.size() == 0) {
+					return;
+				}
+			}
+
+			while (uploadNext()) {}
+		}
+	}
+
+	void TextureManager::cancelPending() {
+		for (const auto& pending : waiting) {
+			const auto it = textureCache.find(pending.key);
+			if (it != textureCache.end() && !it->second.owner_before(pending.texture) && !pending.texture.owner_before(it->second)) {
+				textureCache.erase(it);
+			}
+		}
+
+		_stats.entries = textureCache.size();
+		waiting.clear();
+		queue->pool.waitForDone();
+	}
+
+	DecodedTexture TextureManager::decode(GameFileSystem* fs, const GameFileUri& uri, bool keep_compressed, QThreadPool* pool) {
 		try {
-			file = fs->openFile(tex->fileUri);
+			auto file = fs->openFile(uri);
+			if (file == nullptr) {
+				//TODO make this throw! we should know if this errors, silent fail is bad. currently throwing exception looks to break some character loading.
+				return {};
+			}
+
+			BLPLoader loader(file.get());
+			return loader.decode(keep_compressed, pool);
 		}
-		catch (WDBReader::WDBReaderException& e) {
+		catch (std::exception& e) {
 			Log::message(
-				QString("Error opening blp file (%1)- %2")
-					.arg(tex->fileUri.toString())
+				QString("Error loading blp file (%1)- %2")
+					.arg(uri.toString())
 					.arg(e.what())
 			);
 		}
 
-		if (file == nullptr) {
-			//throw FileIOException(tex->name.toStdString(), "cannot open file.");
-			return;	//TODO make this throw! we should know if this errors, silent fail is bad. currently throwing exception looks to break some character loading.
+		return {};
+	}
+
+	void TextureManager::dispatchDecodes() {
+		// decoded textures can be large, limit how many are held before being uploaded.
+		constexpr size_t MAX_QUEUED_TEXTURES = 16;
+
+		std::lock_guard lock(queue->mutex);
+
+		while (waiting.size() > 0 && queue->decoding + queue->ready.size() < MAX_QUEUED_TEXTURES) {
+			auto pending = std::move(waiting.front());
+			waiting.pop_front();
+
+			if (pending.texture.expired()) {
+				continue;
+			}
+
+			queue->decoding++;
+
+			// the texture is only referenced weakly from the worker, it must never be released outside of the GL thread.
+			queue->pool.start([target = queue.get(), pending = std::move(pending), keep_compressed = compressedUpload]() {
+				// rows of large mips are split across the same private pool.
+				auto decoded = decode(pending.fs, pending.uri, keep_compressed, &target->pool);
+
+				std::lock_guard lock(target->mutex);
+				target->ready.push_back({ pending.texture, std::move(decoded) });
+				target->decoding--;
+				target->changed.notify_all();
+			});
 		}
+	}
 
-		BLPLoader loader(file.get());
-		const auto& header = loader.getHeader();
+	bool TextureManager::uploadNext() {
+		UploadQueue::Decoded next;
 
-		tex->width = header.width;
-		tex->height = header.height;
-		tex->compressed = header.colorEncoding == BLPColorEncoding::COLOR_DXT;
+		{
+			std::lock_guard lock(queue->mutex);
+			if (queue->ready.size() == 0) {
+				return false;
+			}
 
-		loader.loadAll([](int32_t mip_index, uint32_t w, uint32_t h, void* buffer_data) {
-			glTexImage2D(GL_TEXTURE_2D, (GLint)mip_index, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, buffer_data);
-		});
+			next = std::move(queue->ready.front());
+			queue->ready.pop_front();
+		}
+
+		// textures released while decoding are skipped.
+		if (auto tex = next.texture.lock()) {
+			upload(tex.get(), next.data);
+		}
+
+		return true;
+	}
+
+	void TextureManager::upload(Texture* tex, const DecodedTexture& decoded) {
+		if (decoded.mips.size() == 0) {
+			// the placeholder is kept.
+			Log::message("Unable to load texture: " + tex->fileUri.toString());
+			return;
+		}
+
+		tex->width = decoded.width;
+		tex->height = decoded.height;
+		tex->compressed = decoded.compressed;
+
+		glBindTexture(GL_TEXTURE_2D, tex->id);
+
+		for (size_t i = 0; i < decoded.mips.size(); i++) {
+			const auto& mip = decoded.mips[i];
+			if (decoded.compressedFormat != 0) {
+				glCompressedTexImage2DARB(GL_TEXTURE_2D, (GLint)i, decoded.compressedFormat, mip.width, mip.height, 0, (GLsizei)mip.data.size(), mip.data.data());
+			}
+			else {
+				glTexImage2D(GL_TEXTURE_2D, (GLint)i, GL_RGBA8, mip.width, mip.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, mip.data.data());
+			}
+		}
 
 		/*
 		// TODO: Add proper support for mipmaps
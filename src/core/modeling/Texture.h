@@ -2,12 +2,16 @@
 #include <cstdint>
 #include "../../OpenGL.h"
 #include <QString>
+#include <QThreadPool>
 #include "BLP.h"
 #include "../filesystem/GameFileSystem.h"
 #include <span>
 #include "../game/GameConstants.h"
 #include "M2Definitions.h"
 #include "../database/GameDatasetAdaptors.h"
+#include <chrono>
+#include <deque>
+#include <unordered_map>
 
 namespace core {
 
@@ -15,21 +19,57 @@ namespace core {
 
 	typedef GLuint TextureID;
 
+	/// <summary>
+	/// CPU side mip chain of a decoded BLP, produced without a GL context so textures can be decoded on worker threads.
+	/// </summary>
+	struct DecodedTexture {
+		struct Mip {
+			uint32_t width;
+			uint32_t height;
+			std::vector<uint8_t> data;
+		};
+
+		uint32_t width = 0;
+		uint32_t height = 0;
+		// source encoding was DXT.
+		bool compressed = false;
+		// GL compressed format when the mips hold S3TC blocks, 0 when they hold RGBA8 pixels.
+		GLint compressedFormat = 0;
+		std::vector<Mip> mips;
+	};
+
+	/// <summary>
+	/// Decodes BLP textures, the file is read once on construction and must remain open while the loader is used.
+	/// Mips are decoded concurrently (large mips are also split by rows), callbacks are made on the calling thread in mip order.
+	/// </summary>
 	class BLPLoader {
 	public:
 		using callback_t = std::function<void(int32_t, uint32_t, uint32_t, void*)>;
+		// mip index, width, height, GL compressed format, blocks.
+		using compressed_callback_t = std::function<void(int32_t, uint32_t, uint32_t, GLint, std::span<const uint8_t>)>;
 
 		BLPLoader(ArchiveFile* file);
 		const BLPHeader& getHeader() const;
 		void loadAll(callback_t fn);
 		void loadFirst(callback_t fn);
+
+		// passes each mip of a DXT texture through without decoding, returns false (without calling fn) for other encodings.
+		bool loadCompressed(compressed_callback_t fn);
+
+		// decodes every mip, DXT blocks are kept as-is when keep_compressed is set.
+		// row tasks run on 'pool' (the global pool when null), the calling thread also takes part so this is safe from a worker of the same pool.
+		DecodedTexture decode(bool keep_compressed, QThreadPool* pool = nullptr);
 	
 	private:
 		void load(int32_t mip_count, callback_t fn);
+		std::vector<DecodedTexture::Mip> decodeMips(int32_t mip_count, QThreadPool* pool = nullptr);
+
+		// view of a mip's data, empty if the mip is missing or extends past the end of the file.
+		std::span<const uint8_t> mipData(int32_t mip_index, size_t required_size) const;
 
 		ArchiveFile* source;
 		BLPHeader header;
-		std::vector<uint8_t> buffer;
+		std::span<const uint8_t> buffer;
 	};
 
 	class Texture {
@@ -47,26 +87,89 @@ namespace core {
 		virtual ~Texture() {}
 
 		std::vector<uint8_t> getPixels(uint32_t format = GL_RGBA);
+
+		// pixels of the first mip as GL_RGBA or GL_BGRA_EXT, compressed textures are decoded on the cpu.
+		static std::vector<uint8_t> readPixels(GLuint texture_id, uint32_t format = GL_RGBA);
 	};
 
+	/// <summary>
+	/// Textures are returned immediately with a placeholder image, the BLP is then opened and decoded on a worker thread.
+	/// Decoded textures wait in a bounded queue until processUploads() is called from the GL thread.
+	/// </summary>
 	class TextureManager {
 	public:
-		TextureManager() = default;
+		struct Stats {
+			uint64_t hits = 0;
+			uint64_t misses = 0;
+			size_t entries = 0;
+		};
+
+		TextureManager();
 		TextureManager(const TextureManager& instance) = delete;
-		TextureManager(TextureManager&&) = default;
-		virtual ~TextureManager() {}
+		TextureManager(TextureManager&&);
+		virtual ~TextureManager();
 
 		std::shared_ptr<Texture> add(GameFileUri uri, GameFileSystem* fs);
 
+		// uploads decoded textures until the budget is spent (at least one per call), returns the number uploaded.
+		size_t processUploads(std::chrono::microseconds budget);
+
+		// blocks until every added texture has been decoded and uploaded, for callers which need the real texture contents.
+		void finishUploads();
+
+		// drops textures waiting to be decoded and waits for running decodes, must be called before the filesystem they use is destroyed.
+		// textures which were not decoded keep their placeholder, but are removed from the cache so a later add() loads the file again.
+		void cancelPending();
+
+		// opens and decodes a BLP, no GL calls are made. returns no mips if the file cannot be loaded.
+		static DecodedTexture decode(GameFileSystem* fs, const GameFileUri& uri, bool keep_compressed, QThreadPool* pool = nullptr);
+
+		// when enabled DXT textures are uploaded as-is, requires S3TC support from the driver.
+		void setCompressedUpload(bool enabled) {
+			compressedUpload = enabled;
+		}
+
+		bool isCompressedUpload() const {
+			return compressedUpload;
+		}
+
 		inline const std::map<TextureID, std::weak_ptr<Texture>>& textures() {
 			return textureMap;
 		}
 
+		// hits are requests served by an existing texture, e.g shared between attachments or npcs.
+		Stats stats() const {
+			return _stats;
+		}
+
 	protected:
-		void remove(GLuint id);
-		void loadBLP(Texture* tex, GameFileSystem* fs);
+		// file ids are used when known, otherwise the normalised path, so the same file requested by id or path is shared.
+		using key_t = GameFileUri::variant_t;
+
+		struct PendingTexture {
+			std::weak_ptr<Texture> texture;
+			GameFileUri uri;
+			GameFileSystem* fs;
+			key_t key;
+		};
+
+		struct UploadQueue;
+
+		static key_t makeKey(GameFileSystem* fs, const GameFileUri& uri);
+
+		void remove(GLuint id, const key_t& key);
+		void dispatchDecodes();
+		bool uploadNext();
+		void upload(Texture* tex, const DecodedTexture& decoded);
 
 		std::map<TextureID, std::weak_ptr<Texture>> textureMap;
+		std::unordered_map<key_t, std::weak_ptr<Texture>> textureCache;
+		Stats _stats;
+		bool compressedUpload = false;
+
+		// textures waiting for a decode slot, only used from the GL thread.
+		std::deque<PendingTexture> waiting;
+		std::unique_ptr<UploadQueue> queue;
 	};
 
 
@@ -0,0 +1,328 @@
+#include "../../stdafx.h"
+#include "VertexSkinning.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define WMVX_SKINNING_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define WMVX_SKINNING_X86 0
+#endif
+
+// msvc allows intrinsics in any function, gcc / clang need the target enabled per function.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define WMVX_TARGET_SSE2
+#define WMVX_TARGET_AVX2
+#else
+#define WMVX_TARGET_SSE2 __attribute__((target("sse2")))
+#define WMVX_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+namespace core {
+
+	namespace {
+
+		using InfluenceGroup = VertexSkinning::InfluenceGroup;
+		using PaletteEntry = VertexSkinning::PaletteEntry;
+		using KernelFn = void(*)(const InfluenceGroup&, const PaletteEntry*, Vector3*, Vector3*);
+		using KernelTable = std::array<KernelFn, ModelVertexM2::BONE_COUNT>;
+
+		// same operation order as Matrix * Vector3 followed by the weighted sum, so results match the original per vertex loop.
+		template<size_t N>
+		void skinScalar(const InfluenceGroup& group, const PaletteEntry* palette, Vector3* out_vertices, Vector3* out_normals) {
+			const size_t count = group.size();
+
+			const uint16_t* bones[N];
+			const float* weights[N];
+			for (size_t j = 0; j < N; j++) {
+				bones[j] = group.bones[j].data();
+				weights[j] = group.weights[j].data();
+			}
+
+			for (size_t i = 0; i < count; i++) {
+				const float px = group.px[i], py = group.py[i], pz = group.pz[i];
+				const float nx = group.nx[i], ny = group.ny[i], nz = group.nz[i];
+
+				Vector3 v = Vector3(0, 0, 0);
+				Vector3 n = Vector3(0, 0, 0);
+
+				for (size_t j = 0; j < N; j++) {
+					const auto& cols = palette[bones[j][i]].cols;
+					const float w = weights[j][i];
+
+					const Vector3 tv(
+						cols[0][0] * px + cols[1][0] * py + cols[2][0] * pz + cols[3][0],
+						cols[0][1] * px + cols[1][1] * py + cols[2][1] * pz + cols[3][1],
+						cols[0][2] * px + cols[1][2] * py + cols[2][2] * pz + cols[3][2]
+					);
+
+					const Vector3 tn(
+						cols[0][4] * nx + cols[1][4] * ny + cols[2][4] * nz + cols[3][4],
+						cols[0][5] * nx + cols[1][5] * ny + cols[2][5] * nz + cols[3][5],
+						cols[0][6] * nx + cols[1][6] * ny + cols[2][6] * nz + cols[3][6]
+					);
+
+					v += tv * w;
+					n += tn * w;
+				}
+
+				out_vertices[group.targets[i]] = v;
+				out_normals[group.targets[i]] = n;
+			}
+		}
+
+		constexpr KernelTable scalarKernels = { &skinScalar<1>, &skinScalar<2>, &skinScalar<3>, &skinScalar<4> };
+
+#if WMVX_SKINNING_X86
+
+		// one vertex per iteration, xyz in the lower lanes, no fma so results match the scalar kernel.
+		template<size_t N>
+		WMVX_TARGET_SSE2 void skinSSE2(const InfluenceGroup& group, const PaletteEntry* palette, Vector3* out_vertices, Vector3* out_normals) {
+			const size_t count = group.size();
+
+			const uint16_t* bones[N];
+			const float* weights[N];
+			for (size_t j = 0; j < N; j++) {
+				bones[j] = group.bones[j].data();
+				weights[j] = group.weights[j].data();
+			}
+
+			alignas(16) float result[8];
+
+			for (size_t i = 0; i < count; i++) {
+				const __m128 px = _mm_set1_ps(group.px[i]);
+				const __m128 py = _mm_set1_ps(group.py[i]);
+				const __m128 pz = _mm_set1_ps(group.pz[i]);
+				const __m128 nx = _mm_set1_ps(group.nx[i]);
+				const __m128 ny = _mm_set1_ps(group.ny[i]);
+				const __m128 nz = _mm_set1_ps(group.nz[i]);
+
+				__m128 v = _mm_setzero_ps();
+				__m128 n = _mm_setzero_ps();
+
+				for (size_t j = 0; j < N; j++) {
+					const auto& cols = palette[bones[j][i]].cols;
+					const __m128 w = _mm_set1_ps(weights[j][i]);
+
+					__m128 tv = _mm_mul_ps(_mm_load_ps(cols[0]), px);
+					tv = _mm_add_ps(tv, _mm_mul_ps(_mm_load_ps(cols[1]), py));
+					tv = _mm_add_ps(tv, _mm_mul_ps(_mm_load_ps(cols[2]), pz));
+					tv = _mm_add_ps(tv, _mm_load_ps(cols[3]));
+
+					__m128 tn = _mm_mul_ps(_mm_load_ps(cols[0] + 4), nx);
+					tn = _mm_add_ps(tn, _mm_mul_ps(_mm_load_ps(cols[1] + 4), ny));
+					tn = _mm_add_ps(tn, _mm_mul_ps(_mm_load_ps(cols[2] + 4), nz));
+					tn = _mm_add_ps(tn, _mm_load_ps(cols[3] + 4));
+
+					v = _mm_add_ps(v, _mm_mul_ps(tv, w));
+					n = _mm_add_ps(n, _mm_mul_ps(tn, w));
+				}
+
+				_mm_store_ps(result, v);
+				_mm_store_ps(result + 4, n);
+
+				out_vertices[group.targets[i]] = Vector3(result[0], result[1], result[2]);
+				out_normals[group.targets[i]] = Vector3(result[4], result[5], result[6]);
+			}
+		}
+
+		// one vertex per iteration, position in the lower half and normal in the upper half of each register.
+		template<size_t N>
+		WMVX_TARGET_AVX2 void skinAVX2(const InfluenceGroup& group, const PaletteEntry* palette, Vector3* out_vertices, Vector3* out_normals) {
+			const size_t count = group.size();
+
+			const uint16_t* bones[N];
+			const float* weights[N];
+			for (size_t j = 0; j < N; j++) {
+				bones[j] = group.bones[j].data();
+				weights[j] = group.weights[j].data();
+			}
+
+			alignas(32) float result[8];
+
+			for (size_t i = 0; i < count; i++) {
+				const __m256 x = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(group.px[i])), _mm_set1_ps(group.nx[i]), 1);
+				const __m256 y = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(group.py[i])), _mm_set1_ps(group.ny[i]), 1);
+				const __m256 z = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(group.pz[i])), _mm_set1_ps(group.nz[i]), 1);
+
+				__m256 acc = _mm256_setzero_ps();
+
+				for (size_t j = 0; j < N; j++) {
+					const auto& cols = palette[bones[j][i]].cols;
+
+					__m256 t = _mm256_load_ps(cols[3]);
+					t = _mm256_fmadd_ps(_mm256_load_ps(cols[0]), x, t);
+					t = _mm256_fmadd_ps(_mm256_load_ps(cols[1]), y, t);
+					t = _mm256_fmadd_ps(_mm256_load_ps(cols[2]), z, t);
+
+					acc = _mm256_fmadd_ps(t, _mm256_set1_ps(weights[j][i]), acc);
+				}
+
+				_mm256_store_ps(result, acc);
+
+				out_vertices[group.targets[i]] = Vector3(result[0], result[1], result[2]);
+				out_normals[group.targets[i]] = Vector3(result[4], result[5], result[6]);
+			}
+		}
+
+		constexpr KernelTable sse2Kernels = { &skinSSE2<1>, &skinSSE2<2>, &skinSSE2<3>, &skinSSE2<4> };
+		constexpr KernelTable avx2Kernels = { &skinAVX2<1>, &skinAVX2<2>, &skinAVX2<3>, &skinAVX2<4> };
+
+#endif
+
+		VertexSkinning::Kernel detectKernel() {
+#if WMVX_SKINNING_X86
+#ifdef _MSC_VER
+			int info[4];
+			__cpuid(info, 0);
+			const int max_leaf = info[0];
+
+			__cpuid(info, 1);
+			const bool has_sse2 = (info[3] & (1 << 26)) != 0;
+			const bool has_fma = (info[2] & (1 << 12)) != 0;
+			const bool has_osxsave = (info[2] & (1 << 27)) != 0;
+			const bool has_avx = (info[2] & (1 << 28)) != 0;
+
+			bool has_avx2 = false;
+			if (max_leaf >= 7) {
+				__cpuidex(info, 7, 0);
+				has_avx2 = (info[1] & (1 << 5)) != 0;
+			}
+
+			// the os must also save the ymm registers.
+			const bool has_ymm_state = has_osxsave && (_xgetbv(0) & 0x6) == 0x6;
+
+			if (has_avx && has_avx2 && has_fma && has_ymm_state) {
+				return VertexSkinning::Kernel::AVX2;
+			}
+
+			if (has_sse2) {
+				return VertexSkinning::Kernel::SSE2;
+			}
+#else
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+				return VertexSkinning::Kernel::AVX2;
+			}
+
+			if (__builtin_cpu_supports("sse2")) {
+				return VertexSkinning::Kernel::SSE2;
+			}
+#endif
+#endif
+			return VertexSkinning::Kernel::SCALAR;
+		}
+
+		const KernelTable& kernelTable(VertexSkinning::Kernel kernel) {
+			switch (kernel) {
+#if WMVX_SKINNING_X86
+			case VertexSkinning::Kernel::AVX2:
+				return avx2Kernels;
+			case VertexSkinning::Kernel::SSE2:
+				return sse2Kernels;
+#endif
+			default:
+				return scalarKernels;
+			}
+		}
+	}
+
+	VertexSkinning::Kernel VertexSkinning::kernel() {
+		static const Kernel detected = detectKernel();
+		return detected;
+	}
+
+	bool VertexSkinning::supported(Kernel kernel) {
+		const Kernel detected = VertexSkinning::kernel();
+		return kernel == Kernel::SCALAR ||
+			kernel == detected ||
+			(kernel == Kernel::SSE2 && detected == Kernel::AVX2);
+	}
+
+	void VertexSkinning::init(const std::vector<ModelVertexM2>& raw_vertices, size_t bone_count) {
+		vertexCount = raw_vertices.size();
+		boneCount = bone_count;
+		palette.clear();
+
+		for (auto& group : groups) {
+			group = InfluenceGroup();
+		}
+
+		for (uint32_t index = 0; index < raw_vertices.size(); index++) {
+			const auto& vert = raw_vertices[index];
+
+			std::array<uint16_t, ModelVertexM2::BONE_COUNT> bones;
+			std::array<float, ModelVertexM2::BONE_COUNT> weights;
+			size_t influences = 0;
+
+			for (size_t b = 0; b < ModelVertexM2::BONE_COUNT; b++) {
+				if (vert.boneWeights[b] > 0 && vert.bones[b] < bone_count) {
+					bones[influences] = vert.bones[b];
+					weights[influences] = (float)vert.boneWeights[b] / 255.0f;
+					influences++;
+				}
+			}
+
+			const Vector3 position = Vector3::yUpToZUp(vert.position);
+			const Vector3 normal = Vector3::yUpToZUp(vert.normal).normalize();
+
+			auto& group = groups[influences];
+			group.targets.push_back(index);
+			group.px.push_back(position.x);
+			group.py.push_back(position.y);
+			group.pz.push_back(position.z);
+			group.nx.push_back(normal.x);
+			group.ny.push_back(normal.y);
+			group.nz.push_back(normal.z);
+
+			for (size_t j = 0; j < influences; j++) {
+				group.bones[j].push_back(bones[j]);
+				group.weights[j].push_back(weights[j]);
+			}
+		}
+	}
+
+	void VertexSkinning::update(std::span<const ModelBoneAdaptor* const> bones, std::vector<Vector3>& out_vertices, std::vector<Vector3>& out_normals) {
+		update(bones, out_vertices, out_normals, kernel());
+	}
+
+	void VertexSkinning::update(std::span<const ModelBoneAdaptor* const> bones, std::vector<Vector3>& out_vertices, std::vector<Vector3>& out_normals, Kernel kernel) {
+		assert(supported(kernel));
+		assert(bones.size() >= boneCount);
+		assert(out_vertices.size() >= vertexCount);
+		assert(out_normals.size() >= vertexCount);
+
+		palette.resize(boneCount);
+
+		for (size_t b = 0; b < boneCount; b++) {
+			const Matrix& mat = bones[b]->getMat();
+			const Matrix& mrot = bones[b]->getMRot();
+			auto& cols = palette[b].cols;
+
+			for (size_t c = 0; c < 4; c++) {
+				for (size_t r = 0; r < 3; r++) {
+					cols[c][r] = mat.m[r][c];
+					cols[c][4 + r] = mrot.m[r][c];
+				}
+				cols[c][3] = 0.f;
+				cols[c][7] = 0.f;
+			}
+		}
+
+		const auto& kernels = kernelTable(kernel);
+
+		for (size_t influences = 1; influences < groups.size(); influences++) {
+			if (groups[influences].size()) {
+				kernels[influences - 1](groups[influences], palette.data(), out_vertices.data(), out_normals.data());
+			}
+		}
+
+		for (const auto target : groups[0].targets) {
+			out_vertices[target] = Vector3(0, 0, 0);
+			out_normals[target] = Vector3(0, 0, 0);
+		}
+	}
+
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "../utility/Vector3.h"
+#include "M2Definitions.h"
+#include "ModelAdaptors.h"
+
+namespace core {
+
+	/// <summary>
+	/// CPU linear blend skinning.
+	/// Vertices are grouped by their number of bone influences and stored as SoA streams with weights already converted to floats,
+	/// each frame the bone matrices are packed into a palette and a kernel specialised for the influence count is run over each group.
+	/// SSE2 / AVX2 kernels are selected at runtime, with a scalar fallback.
+	/// </summary>
+	class VertexSkinning {
+	public:
+		VertexSkinning() = default;
+		VertexSkinning(VertexSkinning&&) = default;
+		VertexSkinning& operator=(VertexSkinning&&) = default;
+		virtual ~VertexSkinning() {}
+
+		enum class Kernel : uint8_t {
+			SCALAR,
+			SSE2,
+			AVX2
+		};
+
+		// kernel used by update(), detected once from the cpu features.
+		static Kernel kernel();
+
+		// true when the kernel can run on this cpu.
+		static bool supported(Kernel kernel);
+
+		// influences referencing a bone at or above 'bone_count' are dropped (the remaining weights are not renormalised),
+		// the old per vertex loop read past the end of the bone list for these.
+		void init(const std::vector<ModelVertexM2>& raw_vertices, size_t bone_count);
+
+		// bones must contain at least 'bone_count' entries, output vectors must be sized to match the raw vertices.
+		// scalar and sse2 output is bit identical to the old per vertex loop, avx2 uses fma so may differ by a few ulp.
+		void update(std::span<const ModelBoneAdaptor* const> bones, std::vector<Vector3>& out_vertices, std::vector<Vector3>& out_normals);
+		void update(std::span<const ModelBoneAdaptor* const> bones, std::vector<Vector3>& out_vertices, std::vector<Vector3>& out_normals, Kernel kernel);
+
+		size_t size() const {
+			return vertexCount;
+		}
+
+		// packed bone matrix, column 'c' holds [mat(0..3, c) | mrot(0..3, c)] so a single 256 bit lane transforms both the position and normal.
+		struct alignas(32) PaletteEntry {
+			float cols[4][8];
+		};
+
+		// vertices sharing the same number of influences, influences are compacted to the first 'n' slots.
+		struct InfluenceGroup {
+			std::vector<uint32_t> targets;
+			std::vector<float> px, py, pz;
+			std::vector<float> nx, ny, nz;
+			std::array<std::vector<uint16_t>, ModelVertexM2::BONE_COUNT> bones;
+			std::array<std::vector<float>, ModelVertexM2::BONE_COUNT> weights;
+
+			size_t size() const {
+				return targets.size();
+			}
+		};
+
+	protected:
+		size_t vertexCount = 0;
+		size_t boneCount = 0;
+
+		// indexed by influence count, group 0 holds vertices without any weights.
+		std::array<InfluenceGroup, ModelVertexM2::BONE_COUNT + 1> groups;
+		std::vector<PaletteEntry> palette;
+	};
+};
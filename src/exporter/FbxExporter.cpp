@@ -19,10 +19,8 @@ namespace exporter {
 		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
 		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
 
-		std::vector<uint8_t> pixels;
-		pixels.resize(width * height * 4);
-
-		glGetTexImage(GL_TEXTURE_2D, 0, GL_BGRA_EXT, GL_UNSIGNED_BYTE, pixels.data());
+		// compressed textures are decoded on demand.
+		std::vector<uint8_t> pixels = Texture::readPixels(tex_id, GL_BGRA_EXT);
 
 		QImage img((uchar*)pixels.data(), width, height, QImage::Format::Format_ARGB32);
 		img.save(filename);
@@ -422,6 +420,7 @@ namespace exporter {
 		}
 
 		const auto* animation = model->model->getModelAnimationSequenceAdaptors().at(anim_opt.index);
+		model->model->loadAnimation(anim_opt.index);
 		
 		FbxAnimStack* anim_stack = FbxAnimStack::Create(mScene, "Anim Layer");
 		FbxAnimLayer* anim_layer = FbxAnimLayer::Create(mScene, "Anim layer");